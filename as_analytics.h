@@ -0,0 +1,199 @@
+#ifndef AS_ANALYTICS_H
+#define AS_ANALYTICS_H
+
+/***
+ *** Topology analytics over the AS index (customer cones, tiers, depth in the provider DAG,
+ *** peer clique among the tier-1 AS, and cycles of the customer -> provider relation).
+ *** Everything is computed once from a snapshot of the index, and is read-only afterwards.
+ ***/
+
+struct CompressedBitset{
+    // Only the non-zero 64-bit words are stored, with their indexes in ascending order.
+    vector<uint32_t> index;
+    vector<uint64_t> word;
+
+    size_t count(void) const {
+        size_t c = 0;
+        for(const uint64_t w : word){
+            c += __builtin_popcountll(w);
+        }
+        return c;
+    }
+
+    bool test(int id) const {
+        auto it = lower_bound(index.begin(), index.end(), static_cast<uint32_t>(id >> 6));
+        if(it == index.end() || *it != static_cast<uint32_t>(id >> 6)){
+            return false;
+        }
+        return (word[it - index.begin()] >> (id & 63)) & 1;
+    }
+
+    template <typename Function>
+    void for_each(Function f) const {
+        // f(int id) for every id in the set, in ascending order.
+        for(size_t i = 0; i < index.size(); ++i){
+            uint64_t w = word[i];
+            while(w){
+                f(static_cast<int>(index[i] * 64 + __builtin_ctzll(w)));
+                w &= w - 1;
+            }
+        }
+    }
+};
+
+class ASAnalytics{
+public:
+    shared_ptr<const ASGraph> as_graph;
+    vector<int> component;                                 // dense id -> component of the customer -> provider relation
+    vector<shared_ptr<const CompressedBitset>> cone_list;  // component -> customer cone (shared by the members)
+    vector<size_t> cone_size;                              // dense id -> size of the customer cone (including itself)
+    vector<int> depth;                                     // dense id -> longest chain of providers above the AS (0 for tier-1)
+    vector<ASNumber> peer_clique;                          // clique of peering tier-1 AS
+    vector<vector<ASNumber>> provider_cycle_list;          // AS on each cycle of the customer -> provider relation
+
+public:
+    ASAnalytics(shared_ptr<const ASGraph> as_graph){
+        this->as_graph = as_graph;
+        const ASGraph& graph = *as_graph;
+        const int n = static_cast<int>(graph.size());
+
+        int scc_num;
+        component = graph.provider_scc(vector<char>(n, 1), scc_num);
+        vector<vector<int>> member(scc_num);
+        for(int id = 0; id < n; ++id){
+            member[component[id]].push_back(id);
+        }
+        for(int scc = 0; scc < scc_num; ++scc){
+            if(1 < member[scc].size()){
+                vector<ASNumber> cycle;
+                for(const int id : member[scc]){
+                    cycle.push_back(graph.as_number_list[id]);
+                }
+                sort(cycle.begin(), cycle.end());
+                provider_cycle_list.push_back(cycle);
+            }
+        }
+        sort(provider_cycle_list.begin(), provider_cycle_list.end());
+
+        // Components are numbered after their providers, thus the depth is computed in ascending order,
+        // and the height (longest chain of customers below) in descending order.
+        vector<int> scc_depth(scc_num, 0), scc_height(scc_num, 0);
+        for(int scc = 0; scc < scc_num; ++scc){
+            for(const int id : member[scc]){
+                for(const int provider : graph.providers.of(id)){
+                    if(component[provider] != scc){
+                        scc_depth[scc] = max(scc_depth[scc], scc_depth[component[provider]] + 1);
+                    }
+                }
+            }
+        }
+        int max_height = 0;
+        for(int scc = scc_num - 1; scc >= 0; --scc){
+            for(const int id : member[scc]){
+                for(const int customer : graph.customers.of(id)){
+                    if(component[customer] != scc){
+                        scc_height[scc] = max(scc_height[scc], scc_height[component[customer]] + 1);
+                    }
+                }
+            }
+            max_height = max(max_height, scc_height[scc]);
+        }
+        depth.resize(n);
+        for(int id = 0; id < n; ++id){
+            depth[id] = scc_depth[component[id]];
+        }
+
+        // Customer cones, level by level from the stubs. The cones of one level are independent.
+        vector<vector<int>> level_list(scc_num == 0 ? 0 : max_height + 1);
+        for(int scc = 0; scc < scc_num; ++scc){
+            level_list[scc_height[scc]].push_back(scc);
+        }
+        cone_list.resize(scc_num);
+        const size_t word_num = (n + 63) / 64;
+        for(const vector<int>& scc_list : level_list){
+            #pragma omp parallel
+            {
+                vector<uint64_t> dense(word_num, 0);
+                vector<uint32_t> touched;
+                #pragma omp for schedule(dynamic, 16)
+                for(size_t i = 0; i < scc_list.size(); ++i){
+                    const int scc = scc_list[i];
+                    auto set_word = [&](uint32_t index, uint64_t w){
+                        if(dense[index] == 0){
+                            touched.push_back(index);
+                        }
+                        dense[index] |= w;
+                    };
+                    for(const int id : member[scc]){
+                        set_word(id >> 6, uint64_t{1} << (id & 63));
+                        for(const int customer : graph.customers.of(id)){
+                            if(component[customer] != scc){
+                                const CompressedBitset& c = *cone_list[component[customer]];
+                                for(size_t k = 0; k < c.index.size(); ++k){
+                                    set_word(c.index[k], c.word[k]);
+                                }
+                            }
+                        }
+                    }
+                    sort(touched.begin(), touched.end());
+                    CompressedBitset cone;
+                    cone.index = touched;
+                    cone.word.reserve(touched.size());
+                    for(const uint32_t index : touched){
+                        cone.word.push_back(dense[index]);
+                        dense[index] = 0;
+                    }
+                    touched.clear();
+                    cone_list[scc] = make_shared<const CompressedBitset>(std::move(cone));
+                }
+            }
+        }
+        cone_size.resize(n);
+        for(int id = 0; id < n; ++id){
+            cone_size[id] = cone_list[component[id]]->count();
+        }
+
+        // Greedy clique among the tier-1 AS, in descending order of the cone size.
+        vector<int> tier1_list;
+        for(int id = 0; id < n; ++id){
+            if(graph.providers.of(id).empty()){
+                tier1_list.push_back(id);
+            }
+        }
+        stable_sort(tier1_list.begin(), tier1_list.end(), [&](int a, int b){
+            return cone_size[a] > cone_size[b];
+        });
+        vector<int> clique;
+        for(const int id : tier1_list){
+            const IdRange peer_list = graph.peers.of(id);
+            bool peering_all = all_of(clique.begin(), clique.end(), [&](int member_id){
+                return find(peer_list.begin(), peer_list.end(), member_id) != peer_list.end();
+            });
+            if(peering_all){
+                clique.push_back(id);
+            }
+        }
+        for(const int id : clique){
+            peer_clique.push_back(graph.as_number_list[id]);
+        }
+        sort(peer_clique.begin(), peer_clique.end());
+    }
+
+    const CompressedBitset& get_cone(int id) const {
+        return *cone_list[component[id]];
+    }
+
+    vector<ASNumber> get_cone_AS_list(int id) const {
+        vector<ASNumber> as_list;
+        get_cone(id).for_each([&](int cone_id){
+            as_list.push_back(as_graph->as_number_list[cone_id]);
+        });
+        return as_list;
+    }
+
+    bool is_in_cone(int provider, int customer) const {
+        return get_cone(provider).test(customer);
+    }
+};
+
+#endif
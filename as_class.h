@@ -11,8 +11,13 @@ public:
     }
 
     IPAddress get_unique_address(void){
+        // The <index>-th /24 from 10.0.0.0, continued on 11.0.0.0/8 and the following blocks after the 65,535th.
         index += 1;
-        return IPAddress{"10." + to_string(index/256) + "." + to_string(index%256) + ".0/24"};
+        const uint64_t address = (uint64_t{10} << 24) + (static_cast<uint64_t>(index) << 8);
+        if(index <= 0 || UINT32_MAX < address){
+            throw logic_error("\n\033[31m[ERROR] No /24 network is left for the " + to_string(index) + "-th AS: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        return IPv4Prefix{static_cast<uint32_t>(address), 24};
     }
 };
 
@@ -36,26 +41,26 @@ public:
         }
     }
 
-    void show_route(const Route* r){
-        if(r->best_path){
+    void show_route(const Route& r){
+        if(r.best_path){
             std::cout << "  \033[32m>\033[39m ";
         }else{
             std::cout << "    ";
         }
-        std::cout << "\033[1mLocPrf:\033[0m "    << std::setw(4) << r->LocPrf << ", ";
-        std::cout << "\033[1mcome_from\033[0m: " << std::setw(8) << r->come_from << ", ";
-        if(r->aspv != nullopt){
-            std::cout << "\033[1mASPV\033[0m: "      << std::setw(7) << r->aspv.value() << ", ";
-        }else if(r->aspv == nullopt){
+        std::cout << "\033[1mLocPrf:\033[0m "    << std::setw(4) << r.LocPrf << ", ";
+        std::cout << "\033[1mcome_from\033[0m: " << std::setw(8) << r.come_from << ", ";
+        if(r.aspv != nullopt){
+            std::cout << "\033[1mASPV\033[0m: "      << std::setw(7) << r.aspv.value() << ", ";
+        }else if(r.aspv == nullopt){
             std::cout << "\033[1mASPV\033[0m: "      << "-------" << ", ";
         }
-        if(r->isec_v != nullopt){
-            std::cout << "\033[1mIsec\033[0m: "      << std::setw(7) << r->isec_v.value() << ", ";
-        }else if(r->isec_v == nullopt){
+        if(r.isec_v != nullopt){
+            std::cout << "\033[1mIsec\033[0m: "      << std::setw(7) << r.isec_v.value() << ", ";
+        }else if(r.isec_v == nullopt){
             std::cout << "\033[1mIsec\033[0m: "      << "-------" << ", ";
         }
 
-        std::cout << "\033[1mpath\033[0m: "      << string_path(r->path) << "\n";
+        std::cout << "\033[1mpath\033[0m: "      << string_path(r.path) << "\n";
         return;
     }
 
@@ -69,60 +74,48 @@ public:
         }
         std::cout << "\033[39m\n";
 
-        std::cout << "routing table: (best path: \033[32m>\033[39m )" << "\n";
-        for(auto it = routing_table.table.begin(); it != routing_table.table.end(); it++){
-            std::cout << "  " << it->first << "\n";
-            for(const Route* r : it->second){
+        if(routing_table.rib_mode == RibMode::BestOnly){
+            std::cout << "routing table: (best path: \033[32m>\033[39m , other routes are NOT kept)" << "\n";
+        }else{
+            std::cout << "routing table: (best path: \033[32m>\033[39m )" << "\n";
+        }
+        Route r;
+        routing_table.for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            std::cout << "  " << network << "\n";
+            for(size_t i = 0; i < block.size(); ++i){
+                block.get_route(i, r);
                 show_route(r);
             }
-        }
+        });
         std::cout << "====================" << "\n";
 
         return;
     }
 
-    vector<Message> receive_init(Message init_msg){
+    vector<Message> receive_init(const Message& init_msg){
         // "init_msg" has only the members "type" and "src".
-        map<IPAddress, const Route*> best_route_list = routing_table.get_best_route_list();
         vector<Message> new_update_message_list;
         ASNumber update_src = as_number;
         ASNumber update_dst = init_msg.src;
 
-        if(*init_msg.come_from == ComeFrom::Customer){
-            for(auto it = best_route_list.begin(); it != best_route_list.end(); it++){
-                IPAddress address = it->first;
-                const Route* r = it->second;
-                Message new_update_message;
-                if(r->path == ITSELF_VEC){
-                    new_update_message = Message{MessageType::Update, update_src, update_dst, address, Path{{update_src}}, nullopt};
-                }else{
-                    Path p = r->path;
-                    p.push_back(update_src);
-                    new_update_message = Message{MessageType::Update, update_src, update_dst, address, p, nullopt};
-                }
-                new_update_message_list.push_back(new_update_message);
+        // Only the routes from customers (and its own network) are advertised to peers and providers.
+        const bool to_customer = (*init_msg.come_from == ComeFrom::Customer);
+        routing_table.for_each_best_route([&](const IPAddress& address, const Route& r){
+            if(!to_customer && r.come_from != ComeFrom::Customer){
+                return;
             }
-        }else if(*init_msg.come_from == ComeFrom::Peer || *init_msg.come_from == ComeFrom::Provider){
-            for(auto it = best_route_list.begin(); it != best_route_list.end(); it++){
-                IPAddress address = it->first;
-                const Route* r = it->second;
-                Message new_update_message;
-                if(r->come_from == ComeFrom::Customer){
-                    if(r->path == ITSELF_VEC){
-                        new_update_message = Message{MessageType::Update, update_src, update_dst, address, Path{{update_src}}, nullopt};
-                    }else{
-                        Path p = r->path;
-                        p.push_back(update_src);
-                        new_update_message = Message{MessageType::Update, update_src, update_dst, address, p, nullopt};
-                    }
-                }
-                new_update_message_list.push_back(new_update_message);
+            if(r.path == ITSELF_VEC){
+                new_update_message_list.push_back(Message{MessageType::Update, update_src, update_dst, address, Path{{update_src}}, nullopt});
+            }else{
+                Path p = r.path;
+                p.push_back(update_src);
+                new_update_message_list.push_back(Message{MessageType::Update, update_src, update_dst, address, p, nullopt});
             }
-        }
+        });
         return new_update_message_list;
     }
 
-    optional<RouteDiff> update(Message update_msg){
+    optional<RouteDiff> update(const Message& update_msg){
         for(const variant<ASNumber, Itself>& as_on_path : *update_msg.path){
             if(as_number == as_on_path){
                 return nullopt;
@@ -153,6 +146,7 @@ class ASClassList{
 public:
     IPAddressGenerator ip_gen = IPAddressGenerator{};
     map<ASNumber, ASClass> class_list = {};
+    RibMode rib_mode = RibMode::Full;
 
 public:
     ASClassList(int index=0){
@@ -169,15 +163,24 @@ public:
     }
 
     void add_AS(ASNumber asn){
-        if(get_AS(asn) == nullptr){
-            IPAddress address = ip_gen.get_unique_address();
-            this->class_list[asn] = ASClass{asn, address};
+        auto [it, inserted] = class_list.try_emplace(asn);
+        if(inserted){
+            it->second = ASClass{asn, ip_gen.get_unique_address()};
+            it->second.routing_table.set_rib_mode(rib_mode);
         }else{
             std::cout << asn << " has been already exists" << std::endl;
         }
         return;
     }
 
+    void set_rib_mode(RibMode rib_mode){
+        this->rib_mode = rib_mode;
+        for(auto it = class_list.begin(); it != class_list.end(); it++){
+            it->second.routing_table.set_rib_mode(rib_mode);
+        }
+        return;
+    }
+
     void show_AS(ASNumber asn){
         ASClass* as_class = get_AS(asn);
         if(as_class != nullptr){
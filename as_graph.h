@@ -0,0 +1,192 @@
+#ifndef AS_GRAPH_H
+#define AS_GRAPH_H
+
+/***
+ *** Read-only adjacency index built from the connection list.
+ *** AS numbers are mapped to dense ids (ascending order of AS number),
+ *** and every relation is stored in the CSR form (offset + flat array).
+ ***/
+
+struct IdRange{
+    const int* first;
+    const int* last;
+
+    const int* begin(void) const { return first; }
+    const int* end(void)   const { return last; }
+    size_t size(void)      const { return last - first; }
+    bool empty(void)       const { return first == last; }
+};
+
+struct Adjacency{
+    vector<int> offset = {0};
+    vector<int> target;
+
+    IdRange of(int id) const {
+        return IdRange{target.data() + offset[id], target.data() + offset[id + 1]};
+    }
+};
+
+class ASGraph{
+public:
+    vector<ASNumber> as_number_list;        // dense id -> AS number
+    unordered_map<ASNumber, int> dense_id;  // AS number -> dense id
+    Adjacency incident;                     // dense id -> index on the connection list (in order)
+    Adjacency providers;                    // dense id -> dense ids of its providers
+    Adjacency customers;                    // dense id -> dense ids of its customers
+    Adjacency peers;                        // dense id -> dense ids of its peers
+
+public:
+    ASGraph() {}
+    ASGraph(const vector<ASNumber>& as_list, const vector<Connection>& connection_list){
+        as_number_list = as_list;
+        as_number_list.reserve(as_list.size() + 2 * connection_list.size());
+        for(const Connection& c : connection_list){
+            as_number_list.push_back(c.src);
+            as_number_list.push_back(c.dst);
+        }
+        sort(as_number_list.begin(), as_number_list.end());
+        as_number_list.erase(unique(as_number_list.begin(), as_number_list.end()), as_number_list.end());
+        as_number_list.shrink_to_fit();
+
+        dense_id.reserve(as_number_list.size());
+        for(size_t i = 0; i < as_number_list.size(); ++i){
+            dense_id[as_number_list[i]] = static_cast<int>(i);
+        }
+
+        vector<pair<int, int>> src_dst;
+        src_dst.reserve(connection_list.size());
+        for(const Connection& c : connection_list){
+            src_dst.push_back({dense_id[c.src], dense_id[c.dst]});
+        }
+
+        // The connections are visited in the order of the list, thus the neighbors of each AS keep that order.
+        build(incident, [&](auto emit){
+            for(size_t i = 0; i < connection_list.size(); ++i){
+                emit(src_dst[i].first, static_cast<int>(i));
+                if(src_dst[i].first != src_dst[i].second){
+                    emit(src_dst[i].second, static_cast<int>(i));
+                }
+            }
+        });
+        build(providers, [&](auto emit){
+            for(size_t i = 0; i < connection_list.size(); ++i){
+                if(connection_list[i].type == ConnectionType::Down){
+                    emit(src_dst[i].second, src_dst[i].first);
+                }
+            }
+        });
+        build(customers, [&](auto emit){
+            for(size_t i = 0; i < connection_list.size(); ++i){
+                if(connection_list[i].type == ConnectionType::Down){
+                    emit(src_dst[i].first, src_dst[i].second);
+                }
+            }
+        });
+        build(peers, [&](auto emit){
+            for(size_t i = 0; i < connection_list.size(); ++i){
+                if(connection_list[i].type == ConnectionType::Peer){
+                    emit(src_dst[i].first, src_dst[i].second);
+                    emit(src_dst[i].second, src_dst[i].first);
+                }
+            }
+        });
+    }
+
+    size_t size(void) const {
+        return as_number_list.size();
+    }
+
+    int get_id(ASNumber asn) const {
+        auto it = dense_id.find(asn);
+        if(it == dense_id.end()){
+            return -1;
+        }
+        return it->second;
+    }
+
+    int get_tier(int id) const {
+        // Tier 1: no provider, Tier 3: no customer (stub), Tier 2: the others.
+        if(providers.of(id).empty()){
+            return 1;
+        }else if(customers.of(id).empty()){
+            return 3;
+        }
+        return 2;
+    }
+
+    vector<int> provider_scc(const vector<char>& mask, int& scc_num) const {
+        // Strongly connected components of the customer -> provider relation,
+        // restricted to the AS whose mask is set (the others are -1).
+        // Components are numbered in the order of Tarjan's algorithm, thus
+        // a component is always numbered after every component of its providers.
+        const int n = static_cast<int>(size());
+        vector<int> component(n, -1), index(n, -1), low(n, 0);
+        vector<char> on_stack(n, 0);
+        vector<int> stack;
+        vector<pair<int, size_t>> call_stack;
+        int counter = 0;
+        scc_num = 0;
+
+        for(int s = 0; s < n; ++s){
+            if(!mask[s] || index[s] != -1){
+                continue;
+            }
+            index[s] = low[s] = counter++;
+            stack.push_back(s);
+            on_stack[s] = 1;
+            call_stack.push_back({s, 0});
+            while(!call_stack.empty()){
+                const int v = call_stack.back().first;
+                const IdRange next = providers.of(v);
+                if(call_stack.back().second < next.size()){
+                    const int w = next.first[call_stack.back().second++];
+                    if(!mask[w]){
+                        continue;
+                    }
+                    if(index[w] == -1){
+                        index[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        on_stack[w] = 1;
+                        call_stack.push_back({w, 0});
+                    }else if(on_stack[w]){
+                        low[v] = min(low[v], index[w]);
+                    }
+                    continue;
+                }
+                if(low[v] == index[v]){
+                    int w;
+                    do{
+                        w = stack.back();
+                        stack.pop_back();
+                        on_stack[w] = 0;
+                        component[w] = scc_num;
+                    }while(w != v);
+                    ++scc_num;
+                }
+                call_stack.pop_back();
+                if(!call_stack.empty()){
+                    const int u = call_stack.back().first;
+                    low[u] = min(low[u], low[v]);
+                }
+            }
+        }
+        return component;
+    }
+
+private:
+    template <typename Fill>
+    void build(Adjacency& adjacency, Fill fill){
+        const size_t n = size();
+        adjacency.offset.assign(n + 1, 0);
+        fill([&](int from, int /* to */){ ++adjacency.offset[from + 1]; });
+        for(size_t i = 0; i < n; ++i){
+            adjacency.offset[i + 1] += adjacency.offset[i];
+        }
+        adjacency.target.resize(adjacency.offset[n]);
+        vector<int> cursor(adjacency.offset.begin(), adjacency.offset.end() - 1);
+        fill([&](int from, int to){ adjacency.target[cursor[from]++] = to; });
+        return;
+    }
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef BEST_PATH_INDEX_H
+#define BEST_PATH_INDEX_H
+
+/***
+ *** Frozen index of the best paths of all AS to all networks, built after LOTUS::run().
+ *** For each (AS, network), the next hop and the length of the best path are stored on dense matrices.
+ *** A path is reconstructed by following the next hops, except for the entries whose path is not
+ *** the best path of its next hop (the next hop has changed its best path later), which are stored explicitly.
+ *** All functions are const, thus the index can be read by several threads at the same time.
+ ***/
+
+class BestPathIndex{
+public:
+    static constexpr int NO_ROUTE = -1;  // no best path
+    static constexpr int ORIGIN   = -2;  // the network of the AS itself
+
+    shared_ptr<const ASGraph> as_graph;
+    vector<IPAddress> network_list;                   // network id -> network (ascending order)
+    unordered_map<IPAddress, int> network_id;         // network -> network id
+    PrefixTrie prefix_trie;                           // IPv4 prefix -> network id
+    vector<int> next_hop;                             // [network id * AS num + dense id] -> dense id of the next hop, NO_ROUTE or ORIGIN
+    vector<uint16_t> path_length;                     // [network id * AS num + dense id] -> number of AS on the path (0 for ORIGIN)
+    unordered_map<uint64_t, pair<uint32_t, uint16_t>> explicit_path;  // entry -> (offset, length) on explicit_path_list
+    vector<ASNumber> explicit_path_list;              // paths in the displayed order (next hop first)
+
+public:
+    BestPathIndex(shared_ptr<const ASGraph> as_graph, const ASClassList& as_class_list){
+        this->as_graph = as_graph;
+        const int n = static_cast<int>(as_graph->size());
+
+        set<IPAddress> network_set;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.for_each_block([&](const IPAddress& network, const RouteBlock&){
+                network_set.insert(network);
+            });
+        }
+        network_list.assign(network_set.begin(), network_set.end());
+        network_id.reserve(network_list.size());
+        for(size_t i = 0; i < network_list.size(); ++i){
+            network_id[network_list[i]] = static_cast<int>(i);
+            prefix_trie.insert(network_list[i], static_cast<int>(i));
+        }
+        const size_t entry_num = network_list.size() * n;
+        next_hop.assign(entry_num, NO_ROUTE);
+        path_length.assign(entry_num, 0);
+
+        vector<const RoutingTable*> table_list(n, nullptr);
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            table_list[as_graph->get_id(it->first)] = &it->second.routing_table;
+        }
+
+        // Next hops and lengths (each AS fills its own entries).
+        #pragma omp parallel
+        {
+            Path path;
+            #pragma omp for schedule(dynamic, 64)
+            for(int id = 0; id < n; ++id){
+                if(table_list[id] == nullptr){
+                    continue;
+                }
+                table_list[id]->for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                    int best = block.get_best_index();
+                    if(best < 0){
+                        return;
+                    }
+                    block.get_path(best, path);
+                    const size_t entry = entry_index(id, network_id.at(network));
+                    if(path.size() == 1 && holds_alternative<Itself>(path.front())){
+                        next_hop[entry] = ORIGIN;
+                    }else{
+                        next_hop[entry] = as_graph->get_id(get<ASNumber>(path.back()));
+                        path_length[entry] = static_cast<uint16_t>(path.size());
+                    }
+                });
+            }
+        }
+
+        // The paths which cannot be reconstructed by the next hops are stored explicitly.
+        #pragma omp parallel
+        {
+            Path path, next_hop_path;
+            vector<pair<uint64_t, vector<ASNumber>>> local_list;
+            #pragma omp for schedule(dynamic, 64)
+            for(int id = 0; id < n; ++id){
+                if(table_list[id] == nullptr){
+                    continue;
+                }
+                table_list[id]->for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                    const size_t entry = entry_index(id, network_id.at(network));
+                    if(next_hop[entry] < 0){
+                        return;
+                    }
+                    block.get_path(block.get_best_index(), path);
+                    const int hop = next_hop[entry];
+                    if(table_list[hop] == nullptr || !table_list[hop]->get_best_path(network, next_hop_path) || !is_consistent(path, next_hop_path)){
+                        vector<ASNumber> displayed_path;
+                        for(auto as_it = path.rbegin(); as_it != path.rend(); ++as_it){
+                            displayed_path.push_back(get<ASNumber>(*as_it));
+                        }
+                        local_list.push_back({entry, displayed_path});
+                    }
+                });
+            }
+            #pragma omp critical
+            {
+                for(const auto& [entry, displayed_path] : local_list){
+                    explicit_path[entry] = {static_cast<uint32_t>(explicit_path_list.size()), static_cast<uint16_t>(displayed_path.size())};
+                    explicit_path_list.insert(explicit_path_list.end(), displayed_path.begin(), displayed_path.end());
+                }
+            }
+        }
+    }
+
+    size_t entry_index(int id, int network) const {
+        return static_cast<size_t>(network) * as_graph->size() + id;
+    }
+
+    int get_network_id(const IPAddress& network) const {
+        auto it = network_id.find(network);
+        return it == network_id.end() ? -1 : it->second;
+    }
+
+    int get_longest_match(int id, const IPAddress& destination) const {
+        // The network id of the longest prefix matching the destination (an address as /32, or a prefix)
+        // among the networks to which the AS has a best path, -1 if there is none.
+        int match = -1;
+        prefix_trie.for_each_match(destination, [&](int network){
+            if(next_hop[entry_index(id, network)] != NO_ROUTE){
+                match = network;
+                return true;
+            }
+            return false;
+        });
+        return match;
+    }
+
+    int get_next_hop(int id, int network) const {
+        // Dense id of the next hop, NO_ROUTE or ORIGIN.
+        return next_hop[entry_index(id, network)];
+    }
+
+    int get_path_length(int id, int network) const {
+        // -1 if there is no best path.
+        const size_t entry = entry_index(id, network);
+        return next_hop[entry] == NO_ROUTE ? -1 : path_length[entry];
+    }
+
+    template <typename Function>
+    bool for_each_hop(int id, int network, Function f) const {
+        // f(ASNumber as_number) for each AS on the best path, in the displayed order (next hop first, origin last).
+        // Returns false if there is no best path.
+        size_t entry = entry_index(id, network);
+        if(next_hop[entry] == NO_ROUTE){
+            return false;
+        }
+        while(0 <= next_hop[entry]){
+            auto it = explicit_path.find(entry);
+            if(it != explicit_path.end()){
+                for(uint32_t i = it->second.first; i < it->second.first + it->second.second; ++i){
+                    f(explicit_path_list[i]);
+                }
+                return true;
+            }
+            const int hop = next_hop[entry];
+            f(as_graph->as_number_list[hop]);
+            entry = entry_index(hop, network);
+        }
+        return true;
+    }
+
+    optional<Path> get_best_path(ASNumber as_number, const IPAddress& network) const {
+        // The same path as RoutingTable::get_best_path() (in the internal order).
+        const int id = as_graph->get_id(as_number);
+        const int network_index = get_network_id(network);
+        if(id < 0 || network_index < 0 || next_hop[entry_index(id, network_index)] == NO_ROUTE){
+            return nullopt;
+        }
+        if(next_hop[entry_index(id, network_index)] == ORIGIN){
+            return ITSELF_VEC;
+        }
+        Path path;
+        for_each_hop(id, network_index, [&](ASNumber hop){ path.push_back(hop); });
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+private:
+    static bool is_consistent(const Path& path, const Path& next_hop_path){
+        // Whether the path (internal order) is the best path of its next hop followed by the next hop.
+        if(next_hop_path.size() == 1 && holds_alternative<Itself>(next_hop_path.front())){
+            return path.size() == 1;
+        }
+        return path.size() == next_hop_path.size() + 1 && equal(next_hop_path.begin(), next_hop_path.end(), path.begin());
+    }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/***
+ *** Periodic checkpoints of LOTUS::run(), to continue a long run by LOTUS::resume() after the process has been killed.
+ *** Checkpoint k is written in the directory as three files:
+ ***   - <k>.rib   : the routing tables. The first checkpoint of a run (the base) has all of them, and the others only
+ ***                 have the (AS, network) entries updated since the previous checkpoint.
+ ***   - <k>.queue : the message queue. The base has all of it, and the others have the number of messages kept
+ ***                 from the previous checkpoint (its last ones) and the messages pushed since then.
+ ***   - <k>.ckpt  : the policies and the security objects at checkpoint k, and the index of its base.
+ *** Checkpoint k is restored by applying the .rib and .queue files of <base>, ..., <k> in order. <k>.ckpt is written
+ *** last, thus a checkpoint whose .ckpt file exists is complete. A new base is written when the later files have
+ *** become larger than those of the base, and the files no longer needed are removed.
+ ***/
+
+const char CHECKPOINT_MAGIC[8] = {'L', 'O', 'T', 'U', 'S', 'C', 'K', 'P'};
+
+class Checkpoint{
+public:
+    string directory;
+    size_t message_interval;                       // messages between the checkpoints (0: no limit)
+    double second_interval;                        // seconds between the checkpoints (0: no limit)
+    long long next_index = 0;
+    long long base_index = -1;                     // -1 until the base of the current run is written
+    uintmax_t base_size = 0;                       // bytes of <base>.rib and <base>.queue
+    uintmax_t delta_size = 0;                      // bytes of the .rib and .queue files after the base
+    bool resumed = false;                          // the next run() continues the checkpoints restored by resume()
+    unordered_set<uint64_t> dirty_set;             // entries changed since the last checkpoint (see mark_dirty())
+    size_t last_message_num = 0;
+    uint64_t last_push_num = 0;                    // MessageQueue::get_push_num() at the last checkpoint
+    chrono::steady_clock::time_point last_time;
+
+public:
+    Checkpoint(const string& directory, size_t message_interval, double second_interval){
+        this->directory = directory;
+        this->message_interval = message_interval;
+        this->second_interval = second_interval;
+        vector<long long> index_list = list_index(".rib");
+        if(!index_list.empty()){
+            next_index = index_list.back() + 1;
+        }
+    }
+
+    void mark_dirty(ASNumber as_number, uint32_t network_id){
+        // <network_id> is the id of the network in the message queue, which is not cleared during run().
+        dirty_set.insert((static_cast<uint64_t>(static_cast<uint32_t>(as_number)) << 32) | network_id);
+    }
+
+    string file_path(long long index, const string& extension) const {
+        return directory + "/" + to_string(index) + extension;
+    }
+
+    void start(uint64_t push_num){
+        // Called at the beginning of run(), with MessageQueue::get_push_num().
+        if(!resumed){
+            base_index = -1;
+        }
+        resumed = false;
+        dirty_set.clear();
+        last_message_num = 0;
+        last_push_num = push_num;
+        last_time = chrono::steady_clock::now();
+    }
+
+    bool is_due(size_t processed_msg_num) const {
+        if(0 < message_interval && message_interval <= processed_msg_num - last_message_num){
+            return true;
+        }
+        // The clock is read once every 1024 messages.
+        return 0.0 < second_interval && processed_msg_num % 1024 == 0
+            && second_interval <= chrono::duration<double>(chrono::steady_clock::now() - last_time).count();
+    }
+
+    void continue_from(long long index, long long base_index){
+        // Called by LOTUS::resume(), thus the next run() writes checkpoint <index + 1> on this chain.
+        this->base_index = base_index;
+        next_index = index + 1;
+        resumed = true;
+        base_size = chain_size(base_index);
+        delta_size = 0;
+        for(long long i = base_index + 1; i <= index; ++i){
+            delta_size += chain_size(i);
+        }
+    }
+
+    uintmax_t chain_size(long long index) const {
+        // Bytes of the files of checkpoint <index> applied on its base.
+        error_code ec;
+        uintmax_t size = 0;
+        for(const char* extension : {".rib", ".queue"}){
+            const uintmax_t file_size = filesystem::file_size(file_path(index, extension), ec);
+            size += ec ? 0 : file_size;
+        }
+        return size;
+    }
+
+    void written(long long index, size_t processed_msg_num, uint64_t push_num){
+        // Called after checkpoint <index> has been written.
+        const uintmax_t size = chain_size(index);
+        if(base_index < 0){
+            base_index = index;
+            base_size = size;
+            delta_size = 0;
+        }else{
+            delta_size += size;
+        }
+        next_index = index + 1;
+        dirty_set.clear();
+        last_message_num = processed_msg_num;
+        last_push_num = push_num;
+        last_time = chrono::steady_clock::now();
+
+        // Only the files of the last checkpoint (and the .rib and .queue files since its base) are kept.
+        for(const long long old_index : list_index(".ckpt")){
+            if(old_index < index){
+                unlink(file_path(old_index, ".ckpt").c_str());
+            }
+        }
+        for(const char* extension : {".rib", ".queue"}){
+            for(const long long old_index : list_index(extension)){
+                if(old_index < base_index){
+                    unlink(file_path(old_index, extension).c_str());
+                }
+            }
+        }
+        error_code ec;
+        // The temporary files of a killed process.
+        for(const auto& entry : filesystem::directory_iterator(directory, ec)){
+            if(entry.path().filename().string().find(".tmp") != string::npos){
+                filesystem::remove(entry.path(), ec);
+            }
+        }
+        if(base_size < delta_size){
+            base_index = -1;
+        }
+    }
+
+    vector<long long> list_index(const string& extension) const {
+        // The indexes of the files "<index><extension>" in the directory, in ascending order.
+        vector<long long> index_list;
+        error_code ec;
+        for(const auto& entry : filesystem::directory_iterator(directory, ec)){
+            const string name = entry.path().filename().string();
+            if(name.size() <= extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0){
+                continue;
+            }
+            long long index;
+            auto [p, parse_ec] = from_chars(name.data(), name.data() + name.size() - extension.size(), index);
+            if(parse_ec == errc() && p == name.data() + name.size() - extension.size()){
+                index_list.push_back(index);
+            }
+        }
+        sort(index_list.begin(), index_list.end());
+        return index_list;
+    }
+};
+
+#endif
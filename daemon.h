@@ -0,0 +1,324 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/***
+ *** A long-lived server answering scenario requests over a Unix domain socket, on a baseline loaded and converged once.
+ *** A request is one line, and its answer is one line of JSON ({"error": ...} for a wrong request).
+ ***   - attack <attacker> <victim> [aspa|isec <AS>,<AS>,...] [subprefix] [priority <n>]
+ ***         the hijack rate of the attack, with the given adopting AS (see ScenarioRunner).
+ ***   - path <AS> <destination AS>
+ ***         the best path of <AS> to the network of <destination AS> on the baseline (next hop first).
+ ***   - shutdown
+ ***         stops the server after the requests being handled.
+ *** The connections are handled by a pool of threads, and a connection can send several requests.
+ *** A connection is closed after <idle_second> seconds without a request, thus idle clients cannot hold all the threads,
+ *** and the connections (open or waiting for a thread) are closed when the server stops.
+ ***/
+
+class ScenarioDaemon{
+public:
+    static constexpr int POLL_MILLISECOND = 200;  // interval of checking the stop and the idle time of a connection
+
+    LOTUS baseline;
+
+private:
+    LOTUS scenario_base;  // the baseline without any route, from which the runners are made
+    map<tuple<Policy, AttackType, int>, unique_ptr<const ScenarioRunner>> runner_list;
+    mutex runner_mutex;
+    queue<int> client_queue;
+    mutex client_mutex;
+    condition_variable client_ready;
+    atomic<bool> stopped{false};
+    string socket_path;
+    double idle_second = 60.0;
+
+public:
+    ScenarioDaemon(LOTUS& lotus){
+        // The baseline is a fork of <lotus> (usually converged by run()), which is only read afterwards.
+        baseline = lotus.fork();
+        baseline.get_as_graph();
+        scenario_base = baseline.fork();
+        scenario_base.clear_messages();
+        scenario_base.clear_routing_tables();
+    }
+
+    void serve(const string& socket_path, int thread_num=4, double idle_second=60.0){
+        // Blocks until a shutdown request.
+        this->socket_path = socket_path;
+        this->idle_second = idle_second;
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if(sizeof(address.sun_path) <= socket_path.size()){
+            throw logic_error("\n\033[31m[ERROR] The socket path \"" + socket_path + "\" is too long: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socket_path.c_str());
+        if(listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, 64) != 0){
+            if(0 <= listen_fd){
+                close(listen_fd);
+            }
+            throw logic_error("\n\033[31m[ERROR] The socket \"" + socket_path + "\" CANNOT be listened: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        signal(SIGPIPE, SIG_IGN);  // a client closing its connection early is not an error
+        std::cout << "\033[32m[INFO] Listening on \"" << socket_path << "\" with " << thread_num << " threads.\033[00m" << std::endl;
+
+        stopped = false;
+        vector<thread> worker_list;
+        for(int i = 0; i < max(thread_num, 1); ++i){
+            worker_list.emplace_back([this](){ work(); });
+        }
+        while(!stopped){
+            const int client_fd = accept(listen_fd, nullptr, nullptr);
+            if(client_fd < 0){
+                continue;
+            }
+            if(stopped){
+                close(client_fd);
+                break;
+            }
+            {
+                lock_guard<mutex> lock(client_mutex);
+                client_queue.push(client_fd);
+            }
+            client_ready.notify_one();
+        }
+        client_ready.notify_all();
+        for(thread& worker : worker_list){
+            worker.join();
+        }
+        close_waiting_clients();
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        std::cout << "\033[32m[INFO] The server on \"" << socket_path << "\" has stopped.\033[00m" << std::endl;
+    }
+
+    string answer(const string& request, LOTUS& instance){
+        // The answer to one request, using <instance> as the working copy of the scenarios.
+        istringstream is(request);
+        string command;
+        is >> command;
+        try{
+            if(command == "attack"){
+                return answer_attack(is, instance);
+            }else if(command == "path"){
+                return answer_path(is);
+            }else if(command == "shutdown"){
+                stop();
+                return "{\"shutdown\":true}";
+            }
+            return error_json("unknown request \"" + command + "\"");
+        }catch(const exception& e){
+            return error_json(e.what());
+        }
+    }
+
+private:
+    void work(void){
+        LOTUS instance;
+        while(true){
+            int client_fd;
+            {
+                unique_lock<mutex> lock(client_mutex);
+                client_ready.wait(lock, [this](){ return stopped || !client_queue.empty(); });
+                if(stopped || client_queue.empty()){
+                    return;
+                }
+                client_fd = client_queue.front();
+                client_queue.pop();
+            }
+            handle(client_fd, instance);
+            close(client_fd);
+        }
+    }
+
+    void close_waiting_clients(void){
+        // The connections not taken by any thread when the server stops.
+        lock_guard<mutex> lock(client_mutex);
+        while(!client_queue.empty()){
+            close(client_queue.front());
+            client_queue.pop();
+        }
+    }
+
+    void handle(int client_fd, LOTUS& instance){
+        // Until the client closes the connection, sends no request for <idle_second> seconds, or the server stops.
+        // The requests already received are answered before stopping.
+        string pending;
+        char buffer[4096];
+        chrono::steady_clock::time_point last_time = chrono::steady_clock::now();
+        while(true){
+            size_t end;
+            while((end = pending.find('\n')) != string::npos){
+                string request = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                if(!request.empty() && request.back() == '\r'){
+                    request.pop_back();
+                }
+                if(request.empty()){
+                    continue;
+                }
+                const string response = answer(request, instance) + "\n";
+                size_t written = 0;
+                while(written < response.size()){
+                    const ssize_t n = write(client_fd, response.data() + written, response.size() - written);
+                    if(n < 0 && errno == EINTR){
+                        continue;
+                    }else if(n <= 0){
+                        return;
+                    }
+                    written += n;
+                }
+                last_time = chrono::steady_clock::now();
+            }
+            if(stopped){
+                return;
+            }
+            pollfd client_poll = {client_fd, POLLIN, 0};
+            const int ready = poll(&client_poll, 1, POLL_MILLISECOND);
+            if(ready < 0 && errno == EINTR){
+                continue;
+            }else if(ready < 0){
+                return;
+            }else if(ready == 0){
+                if(idle_second <= chrono::duration<double>(chrono::steady_clock::now() - last_time).count()){
+                    return;
+                }
+                continue;
+            }
+            const ssize_t n = read(client_fd, buffer, sizeof(buffer));
+            if(n < 0 && errno == EINTR){
+                continue;
+            }else if(n <= 0){
+                return;
+            }
+            pending.append(buffer, n);
+            last_time = chrono::steady_clock::now();
+        }
+    }
+
+    void stop(void){
+        // The listening thread is woken up by a connection to itself.
+        stopped = true;
+        client_ready.notify_all();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(0 <= fd){
+            connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            close(fd);
+        }
+    }
+
+    const ScenarioRunner& get_runner(Policy mechanism, AttackType attack_type, int priority){
+        // The runners are made at the first request of each setting, and only read afterwards.
+        lock_guard<mutex> lock(runner_mutex);
+        unique_ptr<const ScenarioRunner>& runner = runner_list[{mechanism, attack_type, priority}];
+        if(!runner){
+            runner = make_unique<const ScenarioRunner>(scenario_base, mechanism, attack_type, priority);
+        }
+        return *runner;
+    }
+
+    ASNumber registered_AS(const string& token){
+        ASNumber as_number = 0;
+        auto [p, ec] = from_chars(token.data(), token.data() + token.size(), as_number);
+        if(ec != errc() || p != token.data() + token.size() || baseline.as_class_list.class_list.count(as_number) == 0){
+            throw logic_error("AS \"" + token + "\" has NOT been registered");
+        }
+        return as_number;
+    }
+
+    string answer_attack(istringstream& is, LOTUS& instance){
+        string attacker_token, victim_token, option;
+        if(!(is >> attacker_token >> victim_token)){
+            throw logic_error("usage: attack <attacker> <victim> [aspa|isec <AS>,<AS>,...] [subprefix] [priority <n>]");
+        }
+        Scenario scenario;
+        scenario.attacker = registered_AS(attacker_token);
+        scenario.victim = registered_AS(victim_token);
+        if(scenario.attacker == scenario.victim){
+            throw logic_error("the attacker and the victim MUST be different");
+        }
+        Policy mechanism = Policy::Aspa;
+        AttackType attack_type = AttackType::ForgedOrigin;
+        int priority = 1;
+        while(is >> option){
+            if(option == "aspa" || option == "isec"){
+                mechanism = (option == "aspa") ? Policy::Aspa : Policy::Isec;
+                string adopter_token;
+                if(!(is >> adopter_token)){
+                    throw logic_error("no adopting AS after \"" + option + "\"");
+                }
+                istringstream adopter_stream(adopter_token);
+                string as_token;
+                while(getline(adopter_stream, as_token, ',')){
+                    if(!as_token.empty()){
+                        scenario.adopter_list.push_back(registered_AS(as_token));
+                    }
+                }
+                sort(scenario.adopter_list.begin(), scenario.adopter_list.end());
+                scenario.adopter_list.erase(unique(scenario.adopter_list.begin(), scenario.adopter_list.end()), scenario.adopter_list.end());
+            }else if(option == "subprefix"){
+                attack_type = AttackType::SubPrefix;
+            }else if(option == "priority" && (is >> priority) && 1 <= priority && priority <= 3){
+                continue;
+            }else{
+                throw logic_error("unknown option \"" + option + "\"");
+            }
+        }
+
+        const ScenarioResult result = get_runner(mechanism, attack_type, priority).run(scenario, instance);
+        ostringstream os;
+        os << setprecision(6);
+        os << "{\"attacker\":" << scenario.attacker << ",\"victim\":" << scenario.victim << ",\"mechanism\":\"" << enum_name(mechanism)
+           << "\",\"attack_type\":\"" << enum_name(attack_type) << "\",\"adopter_num\":" << scenario.adopter_list.size()
+           << ",\"affected_num\":" << result.affected_num << ",\"total_num\":" << result.total_num << ",\"hijack_rate\":" << result.hijack_rate() << "}";
+        return os.str();
+    }
+
+    string answer_path(istringstream& is){
+        string as_token, destination_token;
+        if(!(is >> as_token >> destination_token)){
+            throw logic_error("usage: path <AS> <destination AS>");
+        }
+        const ASNumber as_number = registered_AS(as_token);
+        const ASNumber destination = registered_AS(destination_token);
+        const IPAddress& network = baseline.as_class_list.class_list.at(destination).network_address;
+        Path path;
+        ostringstream os;
+        os << "{\"as\":" << as_number << ",\"destination\":" << destination << ",\"network\":\"" << network << "\",\"path\":";
+        if(!baseline.as_class_list.class_list.at(as_number).routing_table.get_best_path(network, path)){
+            os << "null}";
+            return os.str();
+        }
+        os << "[";
+        bool first = true;
+        for(auto it = path.rbegin(); it != path.rend(); ++it){
+            if(const ASNumber* hop = get_if<ASNumber>(&*it)){
+                os << (first ? "" : ",") << *hop;
+                first = false;
+            }
+        }
+        os << "]}";
+        return os.str();
+    }
+
+    static string error_json(const string& message){
+        string escaped;
+        for(const char c : message){
+            if(c == '"' || c == '\\'){
+                escaped += '\\';
+                escaped += c;
+            }else if(c == '\n'){
+                escaped += ' ';
+            }else if(static_cast<unsigned char>(c) >= 0x20){
+                escaped += c;
+            }
+        }
+        return "{\"error\":\"" + escaped + "\"}";
+    }
+};
+
+#endif
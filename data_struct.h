@@ -30,23 +30,35 @@ bool operator==(const variant<ASNumber, Itself>& lhs, const variant<ASNumber, It
     }, lhs, rhs);
 }
 
-Path parse_path(string path_string){
-    Path path;
-    vector<string> as_string_list;
-    std::stringstream ss(path_string);
-    std::string token;
-    while (std::getline(ss, token, '-')) {
-        as_string_list.push_back(token);
-    }
-    for(const string& as_string : as_string_list){
-        if(caseInsensitiveCompare(as_string, "I")){
+void parse_path(string_view path_string, Path& path){
+    // "path" is overwritten, thus its capacity can be reused.
+    path.clear();
+    size_t begin = 0;
+    while(begin < path_string.size()){
+        size_t end = path_string.find('-', begin);
+        if(end == string_view::npos){
+            end = path_string.size();
+        }
+        string_view as_string = path_string.substr(begin, end - begin);
+        if(as_string.empty() || as_string == "I" || as_string == "i"){
             path.push_back(Itself::I);
         }else{
-            path.push_back(ASNumber(stoi(as_string)));
+            size_t first = as_string.find_first_not_of(" \t");
+            ASNumber as_number;
+            if(first == string_view::npos || from_chars(as_string.data() + first, as_string.data() + as_string.size(), as_number).ec != errc{}){
+                throw invalid_argument("parse_path: \"" + string(path_string) + "\" is not a path.");
+            }
+            path.push_back(as_number);
         }
+        begin = end + 1;
     }
     // The order of the displayed path and the path in the internal data structure are REVERSED.
     reverse(path.begin(), path.end());
+}
+
+Path parse_path(string_view path_string){
+    Path path;
+    parse_path(path_string, path);
     return path;
 }
 
@@ -63,6 +75,52 @@ string string_path(Path path){
     return string_path;
 }
 
+optional<IPv4Prefix> parse_IPv4_prefix(string_view s){
+    // "a.b.c.d/len" or "a.b.c.d" (as /32). nullopt if it is not an IPv4 prefix.
+    uint32_t address = 0;
+    const char* p = s.data();
+    const char* end = s.data() + s.size();
+    for(int i = 0; i < 4; ++i){
+        unsigned int octet;
+        auto result = from_chars(p, end, octet);
+        if(result.ec != errc{} || 255 < octet){
+            return nullopt;
+        }
+        address = (address << 8) | octet;
+        p = result.ptr;
+        if(i < 3){
+            if(p == end || *p != '.'){
+                return nullopt;
+            }
+            ++p;
+        }
+    }
+    int length = 32;
+    if(p != end){
+        if(*p != '/'){
+            return nullopt;
+        }
+        auto result = from_chars(p + 1, end, length);
+        if(result.ec != errc{} || result.ptr != end || length < 0 || 32 < length){
+            return nullopt;
+        }
+    }
+    return IPv4Prefix{address & IPv4Prefix::mask(length), length};
+}
+
+string string_prefix(const IPv4Prefix& prefix){
+    string s;
+    for(int i = 3; i >= 0; --i){
+        s += to_string((prefix.address >> (8 * i)) & 255);
+        s += (i == 0) ? '/' : '.';
+    }
+    return s + to_string(prefix.length);
+}
+
+ostream& operator<<(ostream& os, const IPv4Prefix& prefix){
+    return os << string_prefix(prefix);
+}
+
 struct Message{
     MessageType type;
     ASNumber src;
@@ -85,6 +143,22 @@ struct Connection{
     }
 };
 
+struct ConnectionHash{
+    // Consistent with Connection::operator== (the direction of a peer link is ignored).
+    size_t operator()(const Connection& c) const {
+        uint64_t src = static_cast<uint32_t>(c.src);
+        uint64_t dst = static_cast<uint32_t>(c.dst);
+        if(c.type == ConnectionType::Peer && dst < src){
+            swap(src, dst);
+        }
+        uint64_t key = ((src << 32) | dst) ^ (static_cast<uint64_t>(c.type) << 63);
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
 struct Route{
     Path path;
     ComeFrom come_from;
@@ -94,6 +168,111 @@ struct Route{
     optional<Isec> isec_v;
 };
 
+/***
+ *** Packed storage of the candidate routes to one network.
+ *** All routes of a network are kept in one contiguous block, and their paths
+ *** are concatenated on another one (in the internal order, Itself::I is stored as AS 0).
+ ***/
+#define LOCPRF_CLASS X(Origin, 1000) X(Customer, 200) X(Peer, 100) X(Provider, 50)
+
+#define X(name, value) name,
+enum class LocPrfClass{ LOCPRF_CLASS };
+#undef X
+
+int LocPrf_value(LocPrfClass locprf_class){
+    switch(locprf_class){
+        #define X(name, value) case LocPrfClass::name: return value;
+        LOCPRF_CLASS
+        #undef X
+    }
+    throw logic_error("\n\033[31m[ERROR] Unreachable code reached in function: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+}
+
+optional<LocPrfClass> LocPrf_class(int LocPrf){
+    #define X(name, value) if(LocPrf == value){ return LocPrfClass::name; }
+    LOCPRF_CLASS
+    #undef X
+    return nullopt;
+}
+
+const ASNumber ITSELF_AS_NUMBER = 0;
+
+struct PackedRoute{
+    uint32_t path_offset;
+    uint16_t path_length;
+    uint16_t come_from : 2;  // ComeFrom
+    uint16_t LocPrf    : 2;  // LocPrfClass
+    uint16_t best_path : 1;
+    uint16_t aspv      : 2;  // 0: not evaluated, otherwise ASPV + 1
+    uint16_t isec_v    : 2;  // 0: not evaluated, otherwise Isec + 1
+
+    void set_aspv(optional<ASPV> v){ aspv = v ? static_cast<int>(*v) + 1 : 0; }
+    void set_isec_v(optional<Isec> v){ isec_v = v ? static_cast<int>(*v) + 1 : 0; }
+    optional<ASPV> get_aspv(void) const { if(aspv == 0){ return nullopt; } return static_cast<ASPV>(aspv - 1); }
+    optional<Isec> get_isec_v(void) const { if(isec_v == 0){ return nullopt; } return static_cast<Isec>(isec_v - 1); }
+    int get_LocPrf(void) const { return LocPrf_value(static_cast<LocPrfClass>(LocPrf)); }
+};
+
+struct RouteBlock{
+    vector<PackedRoute> route_list;
+    vector<ASNumber> path_list;
+
+    size_t size(void) const {
+        return route_list.size();
+    }
+
+    int get_best_index(void) const {
+        for(size_t i = 0; i < route_list.size(); ++i){
+            if(route_list[i].best_path){
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void add_route(PackedRoute packed_route, const Path& path){
+        packed_route.path_offset = path_list.size();
+        packed_route.path_length = path.size();
+        for(const variant<ASNumber, Itself>& as_on_path : path){
+            if(const ASNumber* as_number = get_if<ASNumber>(&as_on_path)){
+                path_list.push_back(*as_number);
+            }else{
+                path_list.push_back(ITSELF_AS_NUMBER);
+            }
+        }
+        route_list.push_back(packed_route);
+    }
+
+    void get_path(size_t i, Path& path) const {
+        const PackedRoute& packed_route = route_list[i];
+        path.clear();
+        for(size_t j = packed_route.path_offset; j < packed_route.path_offset + packed_route.path_length; ++j){
+            if(path_list[j] == ITSELF_AS_NUMBER){
+                path.push_back(Itself::I);
+            }else{
+                path.push_back(path_list[j]);
+            }
+        }
+    }
+
+    void get_route(size_t i, Route& r) const {
+        // "r" is overwritten, thus the capacity of its path can be reused while scanning a block.
+        const PackedRoute& packed_route = route_list[i];
+        get_path(i, r.path);
+        r.come_from = static_cast<ComeFrom>(packed_route.come_from);
+        r.LocPrf    = packed_route.get_LocPrf();
+        r.best_path = packed_route.best_path;
+        r.aspv      = packed_route.get_aspv();
+        r.isec_v    = packed_route.get_isec_v();
+    }
+
+    Route get_route(size_t i) const {
+        Route r;
+        get_route(i, r);
+        return r;
+    }
+};
+
 struct RouteDiff{
     ComeFrom come_from;
     Path path;
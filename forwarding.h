@@ -0,0 +1,130 @@
+#ifndef FORWARDING_H
+#define FORWARDING_H
+
+/***
+ *** Data-plane forwarding on the converged routing tables.
+ *** Each AS forwards the packets to the next hop of the best route of the longest prefix matching the destination.
+ *** For one destination, the results of all source AS are computed in one pass, since the walks of
+ *** the sources sharing a next hop are the same afterwards.
+ *** A destination prefix is walked for each of its parts with a different longest match (see PrefixTrie::get_part_list()),
+ *** and the result of an AS is the worst among the parts, thus a hijacked sub-prefix is seen.
+ ***   - Delivered  : reached an AS whose own network is the longest match.
+ ***   - Hijacked   : reached an AS on the attacker list.
+ ***   - BlackHoled : reached an AS without any route to the destination.
+ ***   - Looping    : visited an AS twice.
+ ***/
+
+class ForwardingEngine{
+public:
+    shared_ptr<const BestPathIndex> best_path_index;
+
+public:
+    ForwardingEngine(shared_ptr<const BestPathIndex> best_path_index){
+        this->best_path_index = best_path_index;
+    }
+
+    static int severity(ForwardingResult result){
+        // The order of the results of the parts of a destination (the highest is the result of the AS).
+        switch(result){
+            case ForwardingResult::Delivered:  return 0;
+            case ForwardingResult::BlackHoled: return 1;
+            case ForwardingResult::Looping:    return 2;
+            case ForwardingResult::Hijacked:   return 3;
+        }
+        return 0;
+    }
+
+    vector<int> get_matching_network_list(const IPAddress& destination) const {
+        // The networks matching the destination (an address as /32, or a prefix), the longest first.
+        vector<int> matching_list;
+        best_path_index->prefix_trie.for_each_match(destination, [&](int network){
+            matching_list.push_back(network);
+            return false;
+        });
+        return matching_list;
+    }
+
+    vector<ForwardingResult> forward_all(const IPAddress& destination, const vector<ASNumber>& attacker_list={}) const {
+        // The result for every source AS (indexed by the dense id of the AS index).
+        vector<ForwardingResult> result;
+        for(const IPv4Prefix& part : best_path_index->prefix_trie.get_part_list(destination)){
+            const vector<ForwardingResult> part_result = forward_part(get_matching_network_list(part), attacker_list);
+            if(result.empty()){
+                result = part_result;
+                continue;
+            }
+            for(size_t id = 0; id < result.size(); ++id){
+                if(severity(result[id]) < severity(part_result[id])){
+                    result[id] = part_result[id];
+                }
+            }
+        }
+        return result;
+    }
+
+    vector<ForwardingResult> forward_part(const vector<int>& matching_list, const vector<ASNumber>& attacker_list) const {
+        // The result for every source AS, where each AS forwards by the first network on <matching_list> it has a route to.
+        const ASGraph& graph = *best_path_index->as_graph;
+        const int n = static_cast<int>(graph.size());
+
+        vector<char> is_attacker(n, 0);
+        for(const ASNumber as_number : attacker_list){
+            int id = graph.get_id(as_number);
+            if(id >= 0){
+                is_attacker[id] = 1;
+            }
+        }
+
+        // Next hop of each AS (BestPathIndex::ORIGIN when delivered, NO_ROUTE when black-holed).
+        auto forward = [&](int id){
+            for(const int network : matching_list){
+                const int hop = best_path_index->get_next_hop(id, network);
+                if(hop != BestPathIndex::NO_ROUTE){
+                    return hop;
+                }
+            }
+            return BestPathIndex::NO_ROUTE;
+        };
+
+        vector<ForwardingResult> result(n);
+        vector<char> state(n, 0);  // 0: not visited, 1: on the current walk, 2: done
+        vector<int> walk;
+        for(int source = 0; source < n; ++source){
+            int id = source;
+            ForwardingResult walk_result;
+            while(true){
+                if(state[id] == 2){
+                    walk_result = result[id];
+                    break;
+                }else if(state[id] == 1){
+                    walk_result = ForwardingResult::Looping;
+                    break;
+                }
+                if(is_attacker[id]){
+                    walk_result = ForwardingResult::Hijacked;
+                    walk.push_back(id);
+                    break;
+                }
+                const int hop = forward(id);
+                walk.push_back(id);
+                state[id] = 1;
+                if(hop == BestPathIndex::ORIGIN){
+                    walk_result = ForwardingResult::Delivered;
+                    break;
+                }else if(hop == BestPathIndex::NO_ROUTE){
+                    walk_result = ForwardingResult::BlackHoled;
+                    break;
+                }
+                id = hop;
+            }
+            for(const int walked : walk){
+                result[walked] = walk_result;
+                state[walked] = 2;
+            }
+            walk.clear();
+        }
+        return result;
+    }
+};
+
+#endif
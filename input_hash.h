@@ -0,0 +1,144 @@
+#ifndef INPUT_HASH_H
+#define INPUT_HASH_H
+
+/***
+ *** SHA-256 digest of the inputs of a simulation, to find the converged state of the same inputs (see LOTUS::run_cached()).
+ *** The whole digest is stored in the cache file and compared on loading, thus a collision of the file names is detected.
+ *** The values are hashed in the byte order of the host, thus the digest is only compared on the same kind of host.
+ ***/
+
+class InputHash{
+    array<uint32_t, 8> state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    array<unsigned char, 64> block = {};
+    size_t block_size = 0;
+    uint64_t total_size = 0;
+
+public:
+    using Digest = array<unsigned char, 32>;
+
+    void add_bytes(const void* data, size_t size){
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        total_size += size;
+        while(0 < size){
+            const size_t chunk = min(size, block.size() - block_size);
+            memcpy(block.data() + block_size, bytes, chunk);
+            block_size += chunk;
+            bytes += chunk;
+            size -= chunk;
+            if(block_size == block.size()){
+                transform();
+                block_size = 0;
+            }
+        }
+    }
+
+    template <typename T>
+    void add(const T& x){
+        static_assert(is_trivially_copyable_v<T>);
+        add_bytes(&x, sizeof(T));
+    }
+
+    void add(const string& s){
+        // The length first, thus the boundaries of the strings are also hashed.
+        add<uint64_t>(s.size());
+        add_bytes(s.data(), s.size());
+    }
+
+    template <typename T>
+    void add_list(const vector<T>& list){
+        add<uint64_t>(list.size());
+        for(const T& x : list){
+            add(x);
+        }
+    }
+
+    Digest digest(void) const {
+        // The digest of the values added so far (more values can be added afterwards).
+        InputHash h = *this;
+        const uint64_t bit_size = total_size * 8;
+        const unsigned char pad = 0x80;
+        h.add_bytes(&pad, 1);
+        const unsigned char zero = 0;
+        while(h.block_size != 56){
+            h.add_bytes(&zero, 1);
+        }
+        for(int i = 7; 0 <= i; --i){
+            const unsigned char byte = static_cast<unsigned char>(bit_size >> (8 * i));
+            h.add_bytes(&byte, 1);
+        }
+        Digest d;
+        for(size_t i = 0; i < 8; ++i){
+            for(size_t k = 0; k < 4; ++k){
+                d[4 * i + k] = static_cast<unsigned char>(h.state[i] >> (24 - 8 * k));
+            }
+        }
+        return d;
+    }
+
+    uint64_t get(void) const {
+        // The first 64 bits of the digest.
+        const Digest d = digest();
+        uint64_t value = 0;
+        for(size_t i = 0; i < 8; ++i){
+            value = (value << 8) | d[i];
+        }
+        return value;
+    }
+
+    string hex(void) const {
+        ostringstream os;
+        for(const unsigned char byte : digest()){
+            os << std::hex << setw(2) << setfill('0') << static_cast<int>(byte);
+        }
+        return os.str();
+    }
+
+private:
+    static uint32_t rotate(uint32_t x, int n){
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void transform(void){
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for(int i = 0; i < 16; ++i){
+            w[i] = (uint32_t{block[4 * i]} << 24) | (uint32_t{block[4 * i + 1]} << 16) | (uint32_t{block[4 * i + 2]} << 8) | uint32_t{block[4 * i + 3]};
+        }
+        for(int i = 16; i < 64; ++i){
+            const uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int i = 0; i < 64; ++i){
+            const uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            const uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+};
+
+#endif
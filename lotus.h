@@ -8,6 +8,32 @@
 #include <filesystem>
 #include <sstream>
 #include <variant>
+#include <optional>
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <tuple>
+#include <array>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
 
 #include <yaml-cpp/yaml.h>
 
@@ -16,19 +42,328 @@ using namespace YAML;
 
 #include "util.h"
 #include "data_struct.h"
+#include "as_graph.h"
+#include "prefix_trie.h"
+#include "as_analytics.h"
+#include "security_registry.h"
 #include "routing_table.h"
 #include "as_class.h"
+#include "route_monitor.h"
+#include "best_path_index.h"
+#include "forwarding.h"
 #include "util_convert.h"
+#include "shard.h"
+#include "message_queue.h"
+#include "yaml_stream.h"
+#include "input_hash.h"
+#include "checkpoint.h"
 
+const uint32_t BASELINE_CACHE_VERSION = 3;          // changed when the format of the routes is changed
+const char BASELINE_CACHE_MAGIC[8] = {'L', 'O', 'T', 'U', 'S', 'R', 'I', 'B'};
 const vector<string> SPINNER = {"⠋", "⠙", "⠹", "⠸", "⠼", "⠴", "⠦", "⠧", "⠇", "⠏"};
 
 class LOTUS{
 protected:
-    queue<Message> message_queue;
+    MessageQueue message_queue;
     vector<Connection> connection_list;
     map<ASNumber, vector<ASNumber>> public_aspa_list;
     vector<ASNumber> isec_adopted_as_list;
     map<ASNumber, vector<ASNumber>> public_ProConID;
+    shared_ptr<const ASGraph> as_graph;
+    bool as_graph_outdated = true;
+    shared_ptr<const ASAnalytics> analytics;
+    vector<HijackWatch> hijack_watch_list;
+    optional<TransitIndex> transit_index;  // maintained only when enabled
+    bool transit_index_outdated = true;
+    unordered_set<Connection, ConnectionHash> connection_set;  // the same connections as connection_list, for the duplicate check
+    bool connection_set_outdated = true;
+    optional<Checkpoint> checkpoint;  // written by run() only when enabled
+
+    unordered_set<Connection, ConnectionHash>& get_connection_set(void){
+        // The set is rebuilt only when the connection list has been replaced.
+        if(connection_set_outdated){
+            connection_set = unordered_set<Connection, ConnectionHash>(connection_list.begin(), connection_list.end());
+            connection_set_outdated = false;
+        }
+        return connection_set;
+    }
+
+    void run_shard(int shard, const unordered_map<IPAddress, int>& shard_of, int fd){
+        // The worker of run_sharded(): only the networks of the shard are propagated, and their routes are written to fd.
+        auto in_shard = [&](const IPAddress& network){
+            return shard_of.at(network) == shard;
+        };
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.retain(in_shard);
+        }
+        // The spill file (if any) is shared with the coordinator, thus it is only read here.
+        MessageQueue shard_queue;
+        shard_queue.set_memory_limit(message_queue.get_memory_limit(), message_queue.get_spill_directory());
+        message_queue.for_each([&](const Message& msg){
+            if(!msg.address || in_shard(*msg.address)){
+                shard_queue.push(msg);
+            }
+        });
+        message_queue = std::move(shard_queue);
+        transit_index = nullopt;  // rebuilt by the coordinator
+        checkpoint = nullopt;     // written by the coordinator only
+        const size_t message_num = run();
+
+        PipeWriter writer(fd);
+        writer.write<size_t>(message_num);
+        write_routing_tables(writer);
+        if(!writer.flush()){
+            throw logic_error("\n\033[31m[ERROR] The result CANNOT be sent: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        close(fd);
+    }
+
+    map<ASNumber, RoutingTable> save_tables(void){
+        // The routing tables are shared (not copied) into the returned list, and cleared to be rebuilt.
+        map<ASNumber, RoutingTable> saved_table_list;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.share();
+            saved_table_list[it->first] = it->second.routing_table;
+            it->second.routing_table.clear();
+        }
+        return saved_table_list;
+    }
+
+    void restore_tables(map<ASNumber, RoutingTable>& saved_table_list){
+        // The routing tables saved by save_tables() replace the current ones.
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table = std::move(saved_table_list[it->first]);
+        }
+    }
+
+    void set_registry_all(void){
+        // The current security objects are set to the routing tables of all AS classes.
+        shared_ptr<const SecurityRegistry> security_registry = get_security_registry();
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.security_registry = security_registry;
+        }
+    }
+
+    void write_routing_tables(PipeWriter& writer) const {
+        // Every (AS, network) block, followed by AS 0 (never registered) as the end.
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                writer.write<ASNumber>(it->first);
+                writer.write<IPAddress>(network);
+                writer.write_array(block.route_list);
+                writer.write_array(block.path_list);
+            });
+        }
+        writer.write<ASNumber>(0);
+    }
+
+    bool read_routing_tables(PipeReader& reader, size_t& block_num){
+        // Adds the blocks written by write_routing_tables() to the routing tables (overriding the same networks).
+        // false if the stream is truncated or broken.
+        ASNumber as_number;
+        IPAddress network;
+        RouteBlock block;
+        while(reader.read(as_number)){
+            if(as_number == 0){
+                return true;
+            }
+            ASClass* as_class = get_AS(as_number);
+            if(as_class == nullptr || !reader.read(network) || network.length < 0 || 32 < network.length || !reader.read_array(block.route_list) || !reader.read_array(block.path_list)){
+                return false;
+            }
+            as_class->routing_table.get_block(network) = std::move(block);
+            block_num += 1;
+        }
+        return false;
+    }
+
+    InputHash get_topology_hash(void) const {
+        // The AS and the connections (in order), which a checkpoint is restored only on.
+        InputHash h;
+        h.add<uint64_t>(as_class_list.class_list.size());
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            h.add(it->first);
+        }
+        h.add<uint64_t>(connection_list.size());
+        for(const Connection& c : connection_list){
+            h.add(c.type);
+            h.add(c.src);
+            h.add(c.dst);
+        }
+        return h;
+    }
+
+    void write_checkpoint(size_t processed_msg_num){
+        // The routing tables (all of them for the base, otherwise the updated entries), the queue (all of it for the base,
+        // otherwise the messages pushed since the previous checkpoint), then the rest of the state.
+        Checkpoint& cp = *checkpoint;
+        const long long index = cp.next_index;
+        const bool base = cp.base_index < 0;
+        size_t block_num = 0;
+        bool written = write_file_atomically(cp.file_path(index, ".rib"), [&](PipeWriter& writer){
+            writer.write(CHECKPOINT_MAGIC);
+            writer.write(index);
+            if(base){
+                write_routing_tables(writer);
+                return;
+            }
+            vector<pair<ASNumber, IPAddress>> dirty_list;
+            for(const uint64_t key : cp.dirty_set){
+                dirty_list.emplace_back(static_cast<ASNumber>(key >> 32), message_queue.get_network(key & UINT32_MAX));
+            }
+            sort(dirty_list.begin(), dirty_list.end());
+            for(const auto& [as_number, network] : dirty_list){
+                const RouteBlock* block = get_AS(as_number)->routing_table.find_block(network);
+                if(block != nullptr){
+                    writer.write<ASNumber>(as_number);
+                    writer.write<IPAddress>(network);
+                    writer.write_array(block->route_list);
+                    writer.write_array(block->path_list);
+                    block_num += 1;
+                }
+            }
+            writer.write<ASNumber>(0);
+        });
+        const uint64_t push_num = message_queue.get_push_num();
+        written = written && write_file_atomically(cp.file_path(index, ".queue"), [&](PipeWriter& writer){
+            // Only run() changes the queue between the checkpoints, by popping the front and pushing to the back.
+            const size_t pushed = base ? message_queue.size() : min<uint64_t>(push_num - cp.last_push_num, message_queue.size());
+            writer.write(CHECKPOINT_MAGIC);
+            writer.write(index);
+            writer.write<uint64_t>(message_queue.size() - pushed);
+            writer.write<uint64_t>(pushed);
+            message_queue.for_each([&](const Message& msg){
+                writer.write_message(msg);
+            }, message_queue.size() - pushed);
+        });
+        written = written && write_file_atomically(cp.file_path(index, ".ckpt"), [&](PipeWriter& writer){
+            writer.write(CHECKPOINT_MAGIC);
+            writer.write(index);
+            writer.write(cp.base_index < 0 ? index : cp.base_index);
+            writer.write(get_topology_hash().get());
+            for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+                writer.write_array(it->second.routing_table.policy);
+                writer.write(it->second.routing_table.rib_mode);
+            }
+            for(const auto* security_list : {&public_aspa_list, &public_ProConID}){
+                writer.write<uint64_t>(security_list->size());
+                for(auto it = security_list->begin(); it != security_list->end(); it++){
+                    writer.write(it->first);
+                    writer.write_array(it->second);
+                }
+            }
+            writer.write_array(isec_adopted_as_list);
+        });
+        if(!written){
+            std::cout << "\033[33m[WARN] The checkpoint " << index << " CANNOT be written in \"" << cp.directory << "\".\033[00m" << std::endl;
+            return;
+        }
+        cp.written(index, processed_msg_num, push_num);
+    }
+
+    bool restore_checkpoint(const string& directory, long long index){
+        // false (and nothing is changed) if the checkpoint is broken or of another topology.
+        const Checkpoint cp(directory, 0, 0.0);
+        const int fd = open(cp.file_path(index, ".ckpt").c_str(), O_RDONLY);
+        if(fd < 0){
+            return false;
+        }
+        PipeReader reader(fd);
+        char magic[8];
+        long long stored_index, base_index;
+        uint64_t topology_hash;
+        bool valid = reader.read(magic) && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0
+            && reader.read(stored_index) && stored_index == index && reader.read(base_index) && base_index <= index
+            && reader.read(topology_hash) && topology_hash == get_topology_hash().get();
+        vector<pair<vector<Policy>, RibMode>> policy_list;
+        map<ASNumber, vector<ASNumber>> security_list[2];
+        vector<ASNumber> isec_list;
+        MessageQueue restored_queue;
+        restored_queue.set_memory_limit(message_queue.get_memory_limit(), message_queue.get_spill_directory());
+        for(size_t i = 0; valid && i < as_class_list.class_list.size(); ++i){
+            policy_list.emplace_back();
+            valid = reader.read_array(policy_list.back().first) && reader.read(policy_list.back().second);
+        }
+        for(int k = 0; valid && k < 2; ++k){
+            uint64_t size = 0;
+            valid = reader.read(size);
+            for(uint64_t i = 0; valid && i < size; ++i){
+                ASNumber as_number;
+                valid = reader.read(as_number) && reader.read_array(security_list[k][as_number]);
+            }
+        }
+        valid = valid && reader.read_array(isec_list);
+        close(fd);
+        if(!valid){
+            std::cout << "\033[33m[WARN] The checkpoint " << index << " in \"" << directory << "\" is broken or of another topology, it is skipped.\033[00m" << std::endl;
+            return false;
+        }
+
+        // The queue is rebuilt from the .queue files: the messages not kept are popped, and the pushed ones are added.
+        for(long long queue_index = base_index; valid && queue_index <= index; ++queue_index){
+            const int queue_fd = open(cp.file_path(queue_index, ".queue").c_str(), O_RDONLY);
+            if(queue_fd < 0){
+                valid = false;
+                break;
+            }
+            PipeReader queue_reader(queue_fd);
+            uint64_t kept_num = 0, message_num = 0;
+            valid = queue_reader.read(magic) && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0
+                && queue_reader.read(stored_index) && stored_index == queue_index
+                && queue_reader.read(kept_num) && kept_num <= restored_queue.size() && queue_reader.read(message_num);
+            while(valid && kept_num < restored_queue.size()){
+                restored_queue.pop();
+            }
+            for(uint64_t i = 0; valid && i < message_num; ++i){
+                Message msg;
+                valid = queue_reader.read_message(msg);
+                if(valid){
+                    restored_queue.push(msg);
+                }
+            }
+            close(queue_fd);
+        }
+        if(!valid){
+            std::cout << "\033[33m[WARN] The queue of the checkpoint " << index << " in \"" << directory << "\" is missing or broken, it is skipped.\033[00m" << std::endl;
+            return false;
+        }
+
+        // The routing tables are rebuilt from the .rib files (the current tables are kept until they are all read).
+        map<ASNumber, RoutingTable> saved_table_list = save_tables();
+        for(long long rib_index = base_index; valid && rib_index <= index; ++rib_index){
+            const int rib_fd = open(cp.file_path(rib_index, ".rib").c_str(), O_RDONLY);
+            if(rib_fd < 0){
+                valid = false;
+                break;
+            }
+            PipeReader rib_reader(rib_fd);
+            size_t block_num = 0;
+            valid = rib_reader.read(magic) && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0
+                && rib_reader.read(stored_index) && stored_index == rib_index && read_routing_tables(rib_reader, block_num);
+            close(rib_fd);
+        }
+        if(!valid){
+            restore_tables(saved_table_list);
+            std::cout << "\033[33m[WARN] The routing tables of the checkpoint " << index << " in \"" << directory << "\" are missing or broken, it is skipped.\033[00m" << std::endl;
+            return false;
+        }
+
+        size_t i = 0;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++, i++){
+            it->second.policy = policy_list[i].first;
+            it->second.routing_table.policy = policy_list[i].first;
+            it->second.routing_table.rib_mode = policy_list[i].second;
+        }
+        public_aspa_list = std::move(security_list[0]);
+        public_ProConID = std::move(security_list[1]);
+        isec_adopted_as_list = std::move(isec_list);
+        message_queue = std::move(restored_queue);
+        transit_index_outdated = true;
+        if(checkpoint && checkpoint->directory == directory){
+            checkpoint->continue_from(index, base_index);
+        }
+        return true;
+    }
 
 public:
     ASClassList as_class_list;
@@ -43,10 +378,30 @@ public:
             return;
         }else{
             as_class_list.add_AS(asn);
+            as_graph_outdated = true;
             return;
         }
     }
 
+    size_t add_ASes(const vector<ASNumber>& as_list){
+        // Adds the AS in the order of the list, as add_AS() does for each, and returns the number of added AS.
+        size_t added_as_num = 0;
+        for(const ASNumber asn : as_list){
+            if(asn == 0){
+                std::cout << "\033[33m[WARN] Since AS " << asn << " is the special AS number, the AS was NOT added.\033[00m" << std::endl;
+            }else if(as_class_list.class_list.count(asn)){
+                std::cout << "\033[33m[WARN] Since AS " << asn << " already exists, the AS was NOT added.\033[00m" << std::endl;
+            }else{
+                as_class_list.add_AS(asn);
+                ++added_as_num;
+            }
+        }
+        if(0 < added_as_num){
+            as_graph_outdated = true;
+        }
+        return added_as_num;
+    }
+
     ASClass* get_AS(ASNumber asn){
         return as_class_list.get_AS(asn);
     }
@@ -61,6 +416,91 @@ public:
         return;
     }
 
+    LOTUS fork(void){
+        // A new instance in the same state, e.g. to run several scenarios on one converged instance.
+        // The routing tables are shared by both instances, and a network is copied to an instance only
+        // when the instance changes its routes (copy-on-write). The two instances are independent otherwise.
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.share();
+        }
+        LOTUS forked;
+        forked.message_queue = message_queue;
+        forked.connection_list = connection_list;
+        forked.public_aspa_list = public_aspa_list;
+        forked.isec_adopted_as_list = isec_adopted_as_list;
+        forked.public_ProConID = public_ProConID;
+        forked.as_graph = as_graph;
+        forked.as_graph_outdated = as_graph_outdated;
+        forked.analytics = analytics;
+        forked.hijack_watch_list = hijack_watch_list;
+        forked.transit_index = transit_index;
+        forked.transit_index_outdated = transit_index_outdated;
+        // The set of connections is rebuilt from connection_list when it is needed.
+        // The checkpoints are not written by the forked instance (set_checkpoint() with another directory).
+        forked.as_class_list = as_class_list;
+        return forked;
+    }
+
+    void clear_routing_tables(void){
+        // All routes are removed, including the routes to the own networks of the AS.
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.clear();
+        }
+        transit_index_outdated = true;
+        return;
+    }
+
+    shared_ptr<const BestPathIndex> build_best_path_index(void){
+        // Frozen snapshot of the best paths of all AS to all networks, to be built after run().
+        // It is not changed by the following operations on LOTUS, and can be read by several threads.
+        get_as_graph();
+        return make_shared<const BestPathIndex>(as_graph, as_class_list);
+    }
+
+    map<ASNumber, ForwardingResult> get_forwarding_result(ASNumber destination_as, const vector<ASNumber>& attacker_list={}){
+        // Where the packets of every AS to the network of <destination_as> actually go, following the best routes hop by hop.
+        // For many destinations, build a ForwardingEngine once on build_best_path_index() instead.
+        ASClass* destination_as_class = get_AS(destination_as);
+        if(destination_as_class == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << destination_as << " has NOT been registered, the packets CANNOT be forwarded.\033[00m" << std::endl;
+            return {};
+        }
+        return get_forwarding_result(destination_as_class->network_address, attacker_list);
+    }
+
+    map<ASNumber, ForwardingResult> get_forwarding_result(const string& destination, const vector<ASNumber>& attacker_list={}){
+        // The same as above, for a destination address (e.g. "10.0.0.1") or prefix.
+        optional<IPv4Prefix> destination_prefix = parse_IPv4_prefix(destination);
+        if(!destination_prefix){
+            std::cout << "\033[33m[WARN] \"" << destination << "\" is NOT an IPv4 address or prefix, the packets CANNOT be forwarded.\033[00m" << std::endl;
+            return {};
+        }
+        return get_forwarding_result(*destination_prefix, attacker_list);
+    }
+
+    map<ASNumber, ForwardingResult> get_forwarding_result(const IPAddress& destination, const vector<ASNumber>& attacker_list={}){
+        // The longest matching prefix is used at each hop, and a prefix is walked for each of its more specific networks,
+        // thus the packets to a hijacked more specific prefix are seen (see ForwardingEngine::forward_all()).
+        ForwardingEngine engine(build_best_path_index());
+        vector<ForwardingResult> result = engine.forward_all(destination, attacker_list);
+        map<ASNumber, ForwardingResult> result_list;
+        for(size_t id = 0; id < result.size(); ++id){
+            result_list.emplace_hint(result_list.end(), as_graph->as_number_list[id], result[id]);
+        }
+        return result_list;
+    }
+
+    void set_rib_mode(RibMode rib_mode){
+        // RibMode::BestOnly keeps only the best route of each network in every routing table,
+        // the export and show functions then only print these routes.
+        as_class_list.set_rib_mode(rib_mode);
+        return;
+    }
+
+    RibMode get_rib_mode(void){
+        return as_class_list.rib_mode;
+    }
+
     void add_connection(ConnectionType type, ASNumber src, ASNumber dst){
         ASClass* src_as_class = get_AS(src);
         ASClass* dst_as_class = get_AS(dst);
@@ -73,14 +513,55 @@ public:
             return;
         }
         const Connection new_connection = Connection{type, src, dst};
-        if(contains(connection_list, new_connection)){
+        if(!get_connection_set().insert(new_connection).second){
             std::cout << "\033[33m[WARN] Attempted to add a duplicate connection {type = " << type << ", src = " << src << ", dst = " << dst << "}. Ignoring.\033[00m" << std::endl;
             return;
         }
         connection_list.push_back(new_connection);
+        as_graph_outdated = true;
         return;
     }
 
+    size_t add_connections(const vector<Connection>& new_connection_list){
+        // Adds the connections in the order of the list, as add_connection() does for each, and returns the number of added connections.
+        // The AS index is rebuilt only once, when it is used next.
+        unordered_set<Connection, ConnectionHash>& set = get_connection_set();
+        set.reserve(connection_list.size() + new_connection_list.size());
+        connection_list.reserve(connection_list.size() + new_connection_list.size());
+        vector<ASNumber> registered_as_list;  // sorted, since the lookups on the map are slow for large lists
+        registered_as_list.reserve(as_class_list.class_list.size());
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            registered_as_list.push_back(it->first);
+        }
+        auto is_registered = [&](ASNumber asn){
+            return binary_search(registered_as_list.begin(), registered_as_list.end(), asn);
+        };
+        size_t added_connection_num = 0, duplicate_num = 0;
+        for(const Connection& c : new_connection_list){
+            if(!is_registered(c.src)){
+                std::cout << "\033[33m[WARN] Since AS " << c.src << " has NOT been registered, the connection CANNOT be added.\033[00m" << std::endl;
+                continue;
+            }
+            if(!is_registered(c.dst)){
+                std::cout << "\033[33m[WARN] Since AS " << c.dst << " has NOT been registered, the connection CANNOT be added.\033[00m" << std::endl;
+                continue;
+            }
+            if(!set.insert(c).second){
+                ++duplicate_num;
+                continue;
+            }
+            connection_list.push_back(c);
+            ++added_connection_num;
+        }
+        if(0 < duplicate_num){
+            std::cout << "\033[33m[WARN] " << duplicate_num << " duplicate connections were ignored.\033[00m" << std::endl;
+        }
+        if(0 < added_connection_num){
+            as_graph_outdated = true;
+        }
+        return added_connection_num;
+    }
+
     vector<Connection> get_connection(void){
         return connection_list;
     }
@@ -112,7 +593,19 @@ public:
     }
 
     queue<Message> get_messages(void){
-        return message_queue;
+        return message_queue.to_queue();
+    }
+
+    void clear_messages(void){
+        message_queue.clear();
+        return;
+    }
+
+    void set_queue_memory_limit(size_t bytes, const string& spill_directory=""){
+        // The messages over <bytes> (0: no limit) are kept on a file in <spill_directory> (default: the temporary directory).
+        // See message_queue.h.
+        message_queue.set_memory_limit(bytes, spill_directory);
+        return;
     }
 
     optional<Path> get_best_path_to(ASNumber origin_as_number, ASNumber destination_as_number){
@@ -127,15 +620,26 @@ public:
             std::cout << "\033[33m[WARN] Since AS " << destination_as_number << " has NOT been registered.\033[00m" << std::endl;
             return nullopt;
         }
-        IPAddress destination_network = destination_as_class->network_address;
-        if(origin_as_class->routing_table.table.find(destination_network) != origin_as_class->routing_table.table.end()){
-            for(Route* r : origin_as_class->routing_table.table[destination_network]){
-                if(r->best_path){
-                    return r->path;
-                }
-            }
+        return origin_as_class->routing_table.get_best_path(destination_as_class->network_address);
+    }
+
+    optional<Path> get_best_path_to(ASNumber origin_as_number, const string& destination){
+        // The best path from <origin_as_number> to the longest prefix on its routing table matching <destination> (e.g. "10.0.0.1").
+        ASClass* origin_as_class = get_AS(origin_as_number);
+        if(origin_as_class == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << origin_as_number << " has NOT been registered.\033[00m" << std::endl;
+            return nullopt;
+        }
+        optional<IPv4Prefix> destination_prefix = parse_IPv4_prefix(destination);
+        if(!destination_prefix){
+            std::cout << "\033[33m[WARN] \"" << destination << "\" is NOT an IPv4 address or prefix.\033[00m" << std::endl;
+            return nullopt;
         }
-        return nullopt;
+        optional<IPAddress> network = origin_as_class->routing_table.find_longest_match(*destination_prefix);
+        if(!network){
+            return nullopt;
+        }
+        return origin_as_class->routing_table.get_best_path(*network);
     }
 
     void show_messages(void){
@@ -145,16 +649,13 @@ public:
         }
         std::cout << "++++++++++++++++++++" << "\n";
         std::cout << "MESSAGES" << "\n";
-        queue<Message> tmp_msg_queue = message_queue;
-        while(!tmp_msg_queue.empty()){
-            const Message& msg = tmp_msg_queue.front();
+        message_queue.for_each([](const Message& msg){
             if(msg.type == MessageType::Init){
                 std::cout << "  + \033[1m[" << msg.type << "]\033[0m   \033[1msrc\033[0m: " << msg.src << '\n';
             }else if(msg.type == MessageType::Update){
                 std::cout << "  + \033[1m[" << msg.type << "]\033[0m \033[1msrc\033[0m: " << msg.src << ", \033[1mdst\033[0m: " << *msg.dst << ", \033[1mnetwork\033[0m: " << *msg.address << ", \033[1mpath\033[0m: " << string_path(*msg.path) << "\n";
             }
-            tmp_msg_queue.pop();
-        }
+        });
         std::cout << "++++++++++++++++++++" << "\n";
         return;
     }
@@ -167,17 +668,137 @@ public:
         return;
     }
 
+    const ASGraph& get_as_graph(void){
+        // The index is rebuilt only when the connection list has been changed since the last call.
+        if(as_graph_outdated){
+            vector<ASNumber> as_list;
+            as_list.reserve(as_class_list.class_list.size());
+            for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+                as_list.push_back(it->first);
+            }
+            as_graph = make_shared<const ASGraph>(as_list, connection_list);
+            as_graph_outdated = false;
+        }
+        return *as_graph;
+    }
+
     vector<Connection> get_connection_with(ASNumber as_number){
+        const ASGraph& graph = get_as_graph();
         vector<Connection> connected_with;
-        for(const Connection& c : connection_list){
-            if(c.src == as_number || c.dst == as_number){
-                connected_with.push_back(c);
-                continue;
-            }
+        int id = graph.get_id(as_number);
+        if(id < 0){
+            return connected_with;
+        }
+        for(const int connection_index : graph.incident.of(id)){
+            connected_with.push_back(connection_list[connection_index]);
         }
         return connected_with;
     }
 
+    vector<ASNumber> get_random_AS_list(double rate, unsigned int seed){
+        // Returns round(rate * the number of AS) AS chosen at random, in ascending order.
+        // The choice only depends on the seed and the registered AS.
+        if(rate < 0.0 || 1.0 < rate){
+            std::cout << "\033[33m[WARN] The rate " << rate << " is out of range [0, 1], it is clamped.\033[00m" << std::endl;
+            rate = min(max(rate, 0.0), 1.0);
+        }
+        vector<ASNumber> as_list;
+        as_list.reserve(as_class_list.class_list.size());
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            as_list.push_back(it->first);
+        }
+        size_t chosen_num = static_cast<size_t>(llround(rate * as_list.size()));
+        mt19937 rng(seed);
+        for(size_t i = 0; i < chosen_num; ++i){
+            uniform_int_distribution<size_t> dist(i, as_list.size() - 1);
+            swap(as_list[i], as_list[dist(rng)]);
+        }
+        as_list.resize(chosen_num);
+        sort(as_list.begin(), as_list.end());
+        return as_list;
+    }
+
+    vector<ASNumber> get_tier_AS_list(int tier){
+        // Tier 1: AS without any provider, Tier 3: AS without any customer (stub), Tier 2: the others.
+        const ASGraph& graph = get_as_graph();
+        vector<ASNumber> as_list;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            if(graph.get_tier(graph.get_id(it->first)) == tier){
+                as_list.push_back(it->first);
+            }
+        }
+        return as_list;
+    }
+
+    const ASAnalytics& get_analytics(void){
+        // The analytics are recomputed only when the AS index has been rebuilt.
+        get_as_graph();
+        if(analytics == nullptr || analytics->as_graph != as_graph){
+            analytics = make_shared<const ASAnalytics>(as_graph);
+        }
+        return *analytics;
+    }
+
+    size_t get_customer_cone_size(ASNumber as_number){
+        // The number of AS reachable by going down the customers, including the AS itself.
+        const ASAnalytics& a = get_analytics();
+        int id = a.as_graph->get_id(as_number);
+        if(id < 0){
+            std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered, the size of its customer cone is 0.\033[00m" << std::endl;
+            return 0;
+        }
+        return a.cone_size[id];
+    }
+
+    vector<ASNumber> get_customer_cone(ASNumber as_number){
+        const ASAnalytics& a = get_analytics();
+        int id = a.as_graph->get_id(as_number);
+        if(id < 0){
+            std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered, its customer cone is empty.\033[00m" << std::endl;
+            return {};
+        }
+        return a.get_cone_AS_list(id);
+    }
+
+    int get_provider_depth(ASNumber as_number){
+        // The longest chain of providers above the AS (0 for tier-1, -1 if not registered).
+        const ASAnalytics& a = get_analytics();
+        int id = a.as_graph->get_id(as_number);
+        if(id < 0){
+            std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered, its depth is unknown.\033[00m" << std::endl;
+            return -1;
+        }
+        return a.depth[id];
+    }
+
+    vector<ASNumber> get_top_cone_AS_list(size_t num){
+        // <num> AS with the largest customer cones (ties in ascending order of AS number), e.g. the top transit AS.
+        const ASAnalytics& a = get_analytics();
+        vector<int> id_list(a.as_graph->size());
+        for(size_t id = 0; id < id_list.size(); ++id){
+            id_list[id] = static_cast<int>(id);
+        }
+        num = min(num, id_list.size());
+        partial_sort(id_list.begin(), id_list.begin() + num, id_list.end(), [&](int x, int y){
+            return a.cone_size[x] != a.cone_size[y] ? a.cone_size[x] > a.cone_size[y] : x < y;
+        });
+        vector<ASNumber> as_list;
+        for(size_t i = 0; i < num; ++i){
+            as_list.push_back(a.as_graph->as_number_list[id_list[i]]);
+        }
+        return as_list;
+    }
+
+    vector<ASNumber> get_peer_clique(void){
+        // Tier-1 AS peering each other, chosen greedily in descending order of the cone size.
+        return get_analytics().peer_clique;
+    }
+
+    vector<vector<ASNumber>> get_provider_cycle_list(void){
+        // AS on the cycles of the customer -> provider relation (empty if the relation is a DAG).
+        return get_analytics().provider_cycle_list;
+    }
+
     ComeFrom as_a_is_what_on_c(ASNumber as_number, Connection c){
         // E.g. c.type is down, and as_number is the src -> "The AS is the Provider on the connection."
         if(c.type == ConnectionType::Peer){
@@ -192,16 +813,31 @@ public:
         throw logic_error("\n\033[31m[ERROR] Unreachable code reached in function: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
     }
 
-    void run(bool print_progress=false){
+    shared_ptr<const SecurityRegistry> get_security_registry(void){
+        // The published ASPA, the adoption of BGP-iSec and the ProConID, as referred by the routing tables.
+        get_as_graph();
+        return make_shared<const SecurityRegistry>(as_graph, public_aspa_list, isec_adopted_as_list, public_ProConID);
+    }
+
+    size_t run(bool print_progress=false){
+        // Returns the number of processed messages.
         // Set ASPA to the routing table of all AS classes.
-        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
-            it->second.routing_table.public_aspa_list = public_aspa_list;
-            it->second.routing_table.isec_adopted_as_list = isec_adopted_as_list;
-            it->second.routing_table.public_ProConID = public_ProConID;
+        set_registry_all();
+        for(HijackWatch& watch : hijack_watch_list){
+            watch.initialize(as_class_list);
         }
-        int processed_msg_num = 0;
+        if(transit_index){
+            get_transit_index();
+        }
+        const bool monitored = !hijack_watch_list.empty() || transit_index;
+        if(checkpoint){
+            checkpoint->start(message_queue.get_push_num());
+        }
+        Path old_best_path;
+        Message msg;  // the front of the queue, decoded into the same memory every time
+        size_t processed_msg_num = 0;
         while(!message_queue.empty()){
-            Message& msg = message_queue.front();
+            message_queue.get_front(msg);
             if(msg.type == MessageType::Init){
                 for(const Connection& c : get_connection_with(msg.src)){
                     msg.come_from = as_a_is_what_on_c(msg.src, c);
@@ -226,50 +862,316 @@ public:
                         break;
                     }
                 }
-                if(connection == nullopt){return; /* assert False */}
+                if(connection == nullopt){return processed_msg_num; /* assert False */}
 
                 msg.come_from = as_a_is_what_on_c(msg.src, *connection);
+                bool had_best_path = false;
+                if(monitored){
+                    had_best_path = as_class->routing_table.get_best_path(*msg.address, old_best_path);
+                }
+                const size_t change_num = as_class->routing_table.change_num;
                 optional<RouteDiff> route_diff = as_class->update(msg);
+                if(checkpoint && as_class->routing_table.change_num != change_num){
+                    checkpoint->mark_dirty(*msg.dst, message_queue.get_front_network_id());
+                }
+                if(monitored && route_diff != nullopt){
+                    const Path* old_path = had_best_path ? &old_best_path : nullptr;
+                    for(HijackWatch& watch : hijack_watch_list){
+                        if(watch.network.contains(*msg.address)){
+                            watch.update(processed_msg_num + 1, *msg.dst, old_path, *msg.path);
+                        }
+                    }
+                    if(transit_index){
+                        transit_index->update(*msg.address, old_path, *msg.path);
+                    }
+                }
                 if(route_diff == nullopt){
                     // continue;
                 }else if(route_diff->come_from == ComeFrom::Customer){
+                    const uint32_t network_id = message_queue.get_network_id(route_diff->address);
                     for(const Connection& c : connection_with_dst){
-                        Message new_update_message;
-                        new_update_message.type = MessageType::Update;
-                        new_update_message.src = *msg.dst;
-                        new_update_message.path = route_diff->path;
-                        new_update_message.address = route_diff->address;
-                        if(c.src == *msg.dst){
-                            new_update_message.dst = c.dst;
-                        }else if(c.dst == *msg.dst){
-                            new_update_message.dst = c.src;
-                        }
-                        message_queue.push(new_update_message);
+                        const ASNumber new_dst = (c.src == *msg.dst) ? c.dst : c.src;
+                        message_queue.push_update(*msg.dst, new_dst, network_id, route_diff->path);
                     }
                 }else if(route_diff->come_from == ComeFrom::Peer || route_diff->come_from == ComeFrom::Provider){
+                    const uint32_t network_id = message_queue.get_network_id(route_diff->address);
                     for(const Connection& c : connection_with_dst){
                         if(c.type == ConnectionType::Down && c.src == *msg.dst){
-                            Message new_update_message;
-                            new_update_message.type = MessageType::Update;
-                            new_update_message.src = *msg.dst;
-                            new_update_message.dst = c.dst;
-                            new_update_message.path = route_diff->path;
-                            new_update_message.address = route_diff->address;
-                            message_queue.push(new_update_message);
+                            message_queue.push_update(*msg.dst, c.dst, network_id, route_diff->path);
                         }
                     }
                 }
             }
             message_queue.pop();
+            processed_msg_num++;
+            if(checkpoint && checkpoint->is_due(processed_msg_num)){
+                write_checkpoint(processed_msg_num);
+            }
             if(print_progress){
-                processed_msg_num++;
                 std::cout << "\r\033[32m" << SPINNER[(processed_msg_num/2000)%10] << " Running LOTUS, " << std::right << std::setw(8) << processed_msg_num << " finished, " << std::right << std::setw(8) << message_queue.size() << " left.\033[00m" << std::flush;
             }
         }
         if(print_progress){
             std::cout << '\n';
         }
-        return;
+        if(checkpoint){
+            // The converged state, so that resume() does not go back to the middle of this run.
+            write_checkpoint(processed_msg_num);
+        }
+        return processed_msg_num;
+    }
+
+    void set_checkpoint(const string& directory, size_t message_interval=1000000, double second_interval=0.0){
+        // run() writes a checkpoint every <message_interval> messages or <second_interval> seconds (0: no limit),
+        // and at its end. An empty directory disables the checkpoints. See checkpoint.h and resume().
+        if(directory.empty()){
+            checkpoint = nullopt;
+            return;
+        }
+        error_code ec;
+        filesystem::create_directories(directory, ec);
+        checkpoint.emplace(directory, message_interval, second_interval);
+    }
+
+    bool resume(const string& directory, bool print_progress=false){
+        // Restores the newest checkpoint in <directory> (of the same AS and connections as this instance), and
+        // continues the run. Without any checkpoint, the run starts from the current state.
+        // Returns whether a checkpoint has been restored. When set_checkpoint() has been called with the same
+        // directory, the run continues writing the checkpoints after the restored one.
+        vector<long long> index_list = Checkpoint(directory, 0, 0.0).list_index(".ckpt");
+        for(auto index_it = index_list.rbegin(); index_it != index_list.rend(); ++index_it){
+            if(restore_checkpoint(directory, *index_it)){
+                if(!hijack_watch_list.empty()){
+                    std::cout << "\033[33m[WARN] The hijack watches are NOT restored, they only see the messages after the checkpoint.\033[00m" << std::endl;
+                }
+                std::cout << "\033[32m[INFO] Resumed from the checkpoint " << *index_it << " in \"" << directory << "\", " << message_queue.size() << " messages left.\033[00m" << std::endl;
+                run(print_progress);
+                return true;
+            }
+        }
+        std::cout << "\033[32m[INFO] No checkpoint in \"" << directory << "\", running from the current state.\033[00m" << std::endl;
+        run(print_progress);
+        return false;
+    }
+
+    InputHash get_input_hash(void){
+        // The hash of everything run() depends on: the AS with their policies and routing tables, the connections
+        // (in order), the published ASPA, the adoption of BGP-iSec, the ProConID and the messages (in order).
+        InputHash h;
+        h.add<uint32_t>(BASELINE_CACHE_VERSION);
+        h.add<uint64_t>(as_class_list.class_list.size());
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            const RoutingTable& routing_table = it->second.routing_table;
+            h.add(it->first);
+            h.add(it->second.network_address);
+            h.add_list(routing_table.policy);
+            h.add(routing_table.rib_mode);
+            routing_table.for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                h.add(network);
+                // The paths by value, since their offsets depend on the order the routes were added in.
+                h.add<uint64_t>(block.route_list.size());
+                for(const PackedRoute& r : block.route_list){
+                    h.add<uint32_t>((r.come_from << 7) | (r.LocPrf << 5) | (r.best_path << 4) | (r.aspv << 2) | r.isec_v);
+                    h.add<uint32_t>(r.path_length);
+                    h.add_bytes(block.path_list.data() + r.path_offset, r.path_length * sizeof(ASNumber));
+                }
+            });
+            h.add<ASNumber>(0);  // the end of the routing table
+        }
+        h.add<uint64_t>(connection_list.size());
+        for(const Connection& c : connection_list){
+            h.add(c.type);
+            h.add(c.src);
+            h.add(c.dst);
+        }
+        for(const auto* security_list : {&public_aspa_list, &public_ProConID}){
+            h.add<uint64_t>(security_list->size());
+            for(auto it = security_list->begin(); it != security_list->end(); it++){
+                h.add(it->first);
+                h.add_list(it->second);
+            }
+        }
+        h.add_list(isec_adopted_as_list);
+        h.add<uint64_t>(message_queue.size());
+        message_queue.for_each([&](const Message& msg){
+            h.add(msg.type);
+            h.add(msg.src);
+            h.add(msg.dst.value_or(ITSELF_AS_NUMBER));
+            h.add<bool>(msg.address.has_value());
+            h.add(msg.address.value_or(IPAddress{}));
+            h.add<uint64_t>(msg.path ? msg.path->size() : 0);
+            if(msg.path){
+                for(const variant<ASNumber, Itself>& as_on_path : *msg.path){
+                    const ASNumber* as_number = get_if<ASNumber>(&as_on_path);
+                    h.add(as_number ? *as_number : ITSELF_AS_NUMBER);
+                }
+            }
+            h.add<int>(msg.come_from ? static_cast<int>(*msg.come_from) : -1);
+        });
+        return h;
+    }
+
+    bool run_cached(const string& cache_dir="./cache", bool print_progress=false){
+        // The same result as run(). The converged routing tables are stored under <cache_dir>, named by the SHA-256
+        // digest of the inputs (see get_input_hash()), and loaded instead of running when the stored digest is the same.
+        // Returns whether the cache has been hit. The hijack watches are only updated by run(), thus the cache is not
+        // used when any watch is set.
+        if(!hijack_watch_list.empty()){
+            std::cout << "\033[33m[WARN] The hijack watches are only updated by run(), the cache is NOT used.\033[00m" << std::endl;
+            run(print_progress);
+            return false;
+        }
+        const InputHash input_hash = get_input_hash();
+        const string file_path = cache_dir + "/" + input_hash.hex() + ".rib";
+
+        const int read_fd = open(file_path.c_str(), O_RDONLY);
+        if(0 <= read_fd){
+            // The tables are rebuilt from the file; on a broken file they are restored and run() is used.
+            map<ASNumber, RoutingTable> saved_table_list = save_tables();
+            PipeReader reader(read_fd);
+            char magic[8];
+            InputHash::Digest stored_digest;
+            size_t block_num = 0;
+            const bool loaded = reader.read(magic) && memcmp(magic, BASELINE_CACHE_MAGIC, sizeof(magic)) == 0
+                && reader.read(stored_digest) && stored_digest == input_hash.digest() && read_routing_tables(reader, block_num);
+            close(read_fd);
+            if(loaded){
+                message_queue.clear();
+                set_registry_all();
+                transit_index_outdated = true;
+                std::cout << "\033[32m[INFO] Cache hit: " << block_num << " route blocks were loaded from \"" << file_path << "\".\033[00m" << std::endl;
+                return true;
+            }
+            restore_tables(saved_table_list);
+            std::cout << "\033[33m[WARN] The cache \"" << file_path << "\" is broken, it is overwritten.\033[00m" << std::endl;
+        }
+
+        std::cout << "\033[32m[INFO] Cache miss: " << input_hash.hex() << ", running LOTUS.\033[00m" << std::endl;
+        run(print_progress);
+        error_code ec;
+        filesystem::create_directories(cache_dir, ec);
+        const bool stored = write_file_atomically(file_path, [&](PipeWriter& writer){
+            writer.write(BASELINE_CACHE_MAGIC);
+            writer.write(input_hash.digest());
+            write_routing_tables(writer);
+        });
+        if(!stored){
+            std::cout << "\033[33m[WARN] The cache \"" << file_path << "\" CANNOT be written.\033[00m" << std::endl;
+        }
+        return false;
+    }
+
+    vector<ShardSummary> run_sharded(int process_num){
+        // The same result as run(), by <process_num> worker processes, each of which propagates the routes to a
+        // disjoint subset of the networks. The workers are forked from this process, thus the topology and the
+        // routing tables are shared with them (copy-on-write) instead of being copied.
+        // Since the routes to different networks never affect each other, and the messages of one network keep
+        // their order in the queue, the merged routing tables are the same as those of run().
+        // The workers send back the routes of their networks through pipes, and the routing tables of this
+        // instance are replaced by them. Returns the summary of each worker.
+        if(process_num <= 1 || !hijack_watch_list.empty()){
+            if(1 < process_num){
+                std::cout << "\033[33m[WARN] The hijack watches are only updated by run(), the messages are processed in this process.\033[00m" << std::endl;
+            }
+            ShardSummary summary;
+            summary.message_num = run();
+            return {summary};
+        }
+
+        // Every network with a route or an Update message is owned by one worker (in turn, in the order of the network).
+        set<IPAddress> network_set;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.for_each_block([&](const IPAddress& network, const RouteBlock&){
+                network_set.insert(network);
+            });
+        }
+        message_queue.for_each([&](const Message& msg){
+            if(msg.address){
+                network_set.insert(*msg.address);
+            }
+        });
+        unordered_map<IPAddress, int> shard_of;
+        vector<ShardSummary> summary_list(process_num);
+        int network_index = 0;
+        for(const IPAddress& network : network_set){
+            shard_of[network] = network_index % process_num;
+            summary_list[network_index % process_num].network_num += 1;
+            ++network_index;
+        }
+
+        get_as_graph();
+        std::cout << std::flush;
+        vector<pid_t> worker_list;
+        vector<int> pipe_list;
+        auto abort_workers = [&](const string& reason){
+            for(size_t i = 0; i < worker_list.size(); ++i){
+                close(pipe_list[i]);
+                kill(worker_list[i], SIGTERM);
+                waitpid(worker_list[i], nullptr, 0);
+            }
+            throw logic_error("\n\033[31m[ERROR] " + reason + ": " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        };
+        for(int shard = 0; shard < process_num; ++shard){
+            int fd[2];
+            if(pipe(fd) != 0){
+                abort_workers("A pipe CANNOT be created");
+            }
+            const pid_t pid = ::fork();
+            if(pid < 0){
+                close(fd[0]);
+                close(fd[1]);
+                abort_workers("A worker process CANNOT be forked");
+            }else if(pid == 0){
+                // Worker: never returns.
+                close(fd[0]);
+                for(const int other_fd : pipe_list){
+                    close(other_fd);
+                }
+                int status = 0;
+                try{
+                    run_shard(shard, shard_of, fd[1]);
+                }catch(...){
+                    status = 1;
+                }
+                _exit(status);
+            }
+            close(fd[1]);
+            worker_list.push_back(pid);
+            pipe_list.push_back(fd[0]);
+        }
+
+        // The workers are read in turn. A worker waits for the coordinator only after its run.
+        // The current tables are kept until all the results have been read, and are restored if a worker fails,
+        // thus this instance is left unchanged (with its queue) by an error.
+        map<ASNumber, RoutingTable> saved_table_list = save_tables();
+        auto abort_merge = [&](const string& reason){
+            restore_tables(saved_table_list);
+            abort_workers(reason);
+        };
+        for(int shard = 0; shard < process_num; ++shard){
+            PipeReader reader(pipe_list[shard]);
+            ShardSummary& summary = summary_list[shard];
+            if(!reader.read(summary.message_num)){
+                abort_merge("Worker " + to_string(shard) + " has exited without its result");
+            }
+            if(!read_routing_tables(reader, summary.block_num)){
+                abort_merge("The result of worker " + to_string(shard) + " is truncated or broken");
+            }
+        }
+        saved_table_list.clear();
+        for(size_t i = 0; i < worker_list.size(); ++i){
+            close(pipe_list[i]);
+            int status = 0;
+            waitpid(worker_list[i], &status, 0);
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+                std::cout << "\033[33m[WARN] Worker " << i << " has exited abnormally after sending its result.\033[00m" << std::endl;
+            }
+        }
+
+        message_queue.clear();
+        set_registry_all();
+        transit_index_outdated = true;
+        return summary_list;
     }
 
     void file_import(string file_path, bool overwrite=true){
@@ -281,67 +1183,69 @@ public:
         //   - ASPA for newly imported AS will be imported, but providers not newly imported will be discarded.
         //   - Adoption of BGP-iSec will be imported only for newly imported AS.
         //   - All ProConID will be discarded. (use add_ProConID_all())
-        ifstream file(file_path);
-        string line;
+        ifstream file(file_path, ios::binary);
         if(file){
             try{
                 std::cout << "\033[32m[INFO] Parsing \"" << file_path << "\".\033[00m" << std::endl;
 
-                YAML::Node imported = YAML::Load(file);
+                string buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+                ImportedLOTUS imported;
+                try{
+                    imported = LOTUSYAMLLoader::load(buffer);
+                }catch(const exception& e){
+                    // The streaming reader supports only the style written by file_export().
+                    std::cout << "\033[33m[WARN] The streaming reader cannot parse \"" << file_path << "\" (" << e.what() << "), yaml-cpp is used instead.\033[00m" << std::endl;
+                    imported = LOTUSYAMLLoader::load_node(YAML::Load(buffer));
+                }
                 vector<ASNumber> imported_as;
 
                 /* AS LIST */
                 if(overwrite){
-                    as_class_list = ASClassList(imported["IP_gen_seed"].as<int>());
-                    for(const auto& as_node : imported["AS_list"]){
-                        ASNumber as_number = as_node["AS"].as<ASNumber>();
-                        RoutingTable routing_table = as_node["routing_table"].as<RoutingTable>();
-                        vector<Policy> policy = as_node["policy"].as<vector<Policy>>();
-                        routing_table.policy = policy;
-                        as_class_list.class_list[as_number] = ASClass{
-                            as_number,
-                            as_node["network_address"].as<IPAddress>(),
-                            policy,
-                            routing_table
+                    RibMode rib_mode = as_class_list.rib_mode;
+                    as_class_list = ASClassList(imported.IP_gen_seed);
+                    as_class_list.rib_mode = rib_mode;
+                    for(ImportedAS& as : imported.as_list){
+                        as.routing_table.policy = as.policy;
+                        as.routing_table.set_rib_mode(rib_mode);
+                        as_class_list.class_list[as.as_number] = ASClass{
+                            as.as_number,
+                            as.network_address,
+                            as.policy,
+                            std::move(as.routing_table)
                         };
                     }
                 }else{
-                    for(const auto& as_node : imported["AS_list"]){
-                        ASNumber as_number = as_node["AS"].as<ASNumber>();
-                        if(as_class_list.class_list.count(as_number)){
+                    for(const ImportedAS& as : imported.as_list){
+                        if(as_class_list.class_list.count(as.as_number)){
                             continue;
                         }
-                        add_AS(as_number);
-                        imported_as.push_back(as_number);
-                        ASClass* new_as_class = get_AS(as_number);
-                        new_as_class->policy = as_node["policy"].as<vector<Policy>>();
+                        add_AS(as.as_number);
+                        imported_as.push_back(as.as_number);
+                        ASClass* new_as_class = get_AS(as.as_number);
+                        new_as_class->policy = as.policy;
                     }
                 }
+                sort(imported_as.begin(), imported_as.end());
+                auto is_imported = [&](ASNumber as_number){
+                    return binary_search(imported_as.begin(), imported_as.end(), as_number);
+                };
 
                 /* CONNECTION LIST */
                 if(overwrite){
-                    connection_list = {};
-                    for(const auto& c_node : imported["connection"]){
-                        ASNumber src = c_node["src"].as<ASNumber>();
-                        ASNumber dst = c_node["dst"].as<ASNumber>();
-                        ConnectionType type = c_node["type"].as<ConnectionType>();
-                        connection_list.push_back(Connection{type, src, dst});
-                    }
+                    connection_list = std::move(imported.connection_list);
+                    as_graph_outdated = true;
+                    connection_set_outdated = true;
+                    transit_index_outdated = true;
                 }
 
                 /* MESSAGES LIST */
                 if(overwrite){
-                    message_queue = {};
-                    for(const auto& m_node : imported["message"]){
-                        ASNumber src = m_node["src"].as<ASNumber>();
-                        MessageType msgtype = m_node["type"].as<MessageType>();
-                        if(msgtype == MessageType::Init){
-                            add_messages(msgtype, src);
-                        }else if(msgtype == MessageType::Update){
-                            ASNumber dst = m_node["dst"].as<ASNumber>();
-                            IPAddress address = m_node["network"].as<IPAddress>();
-                            Path path = parse_path(m_node["path"].as<string>());
-                            add_messages(msgtype, src, dst, address, path);
+                    message_queue.clear();
+                    for(const Message& msg : imported.message_list){
+                        if(msg.type == MessageType::Init){
+                            add_messages(msg.type, msg.src);
+                        }else if(msg.type == MessageType::Update){
+                            add_messages(msg.type, msg.src, msg.dst, msg.address, msg.path);
                         }
                     }
                 }
@@ -349,36 +1253,24 @@ public:
                 /* ASPA */
                 if(overwrite){
                     public_aspa_list = {};
-                    for(const auto& aspa_node : imported["ASPA"]){
-                        ASNumber customer = aspa_node.first.as<ASNumber>();
-                        for(const auto& provider : aspa_node.second){
-                            public_aspa_list[customer].push_back(provider.as<ASNumber>());
-                        }
+                }
+                for(const auto& [customer, provider_list] : imported.public_aspa_list){
+                    if(!overwrite && !is_imported(customer)){
+                        continue;
                     }
-                }else{
-                    for(const auto& aspa_node : imported["ASPA"]){
-                        ASNumber customer = aspa_node.first.as<ASNumber>();
-                        if(contains(imported_as, customer)){
-                            for(const auto& provider : aspa_node.second){
-                                ASNumber provider_as = provider.as<ASNumber>();
-                                if(contains(imported_as, provider_as)){
-                                    public_aspa_list[customer].push_back(provider_as);
-                                }
-                            }
+                    for(const ASNumber provider_as : provider_list){
+                        if(overwrite || is_imported(provider_as)){
+                            public_aspa_list[customer].push_back(provider_as);
                         }
                     }
                 }
 
                 /* BGP-iSec */
                 if(overwrite){
-                    isec_adopted_as_list = {};
-                    for(const auto& as_it : imported["isec_adopted_as_list"]){
-                        isec_adopted_as_list.push_back(as_it.as<ASNumber>());
-                    }
+                    isec_adopted_as_list = std::move(imported.isec_adopted_as_list);
                 }else{
-                    for(const auto& as_it : imported["isec_adopted_as_list"]){
-                        ASNumber as_number = as_it.as<ASNumber>();
-                        if(contains(imported_as, as_number)){
+                    for(const ASNumber as_number : imported.isec_adopted_as_list){
+                        if(is_imported(as_number)){
                             isec_adopted_as_list.push_back(as_number);
                         }
                     }
@@ -386,10 +1278,9 @@ public:
 
                 if(overwrite){
                     public_ProConID = {};
-                    for(const auto& isec_node : imported["public_ProConID"]){
-                        ASNumber customer = isec_node.first.as<ASNumber>();
-                        for(const auto& provider : isec_node.second){
-                            public_ProConID[customer].push_back(provider.as<ASNumber>());
+                    for(const auto& [customer, provider_list] : imported.public_ProConID){
+                        for(const ASNumber provider_as : provider_list){
+                            public_ProConID[customer].push_back(provider_as);
                         }
                     }
                 }
@@ -404,9 +1295,80 @@ public:
         return;
     }
 
-    void file_export(string file_path_string){
-        YAML::Node export_data;
+    void caida_import(string file_path){
+        // Imports the AS relationships of CAIDA (serial-1 "<AS1>|<AS2>|<rel>" and serial-2 "<AS1>|<AS2>|<rel>|<source>").
+        //   - rel = -1 : AS1 is a provider of AS2 (ConnectionType::Down, src = AS1, dst = AS2).
+        //   - rel =  0 : AS1 and AS2 are peers (ConnectionType::Peer).
+        // The AS and connections are ADDED to the current ones, and duplicated connections are ignored.
+        // Lines beginning with '#' are comments.
+        ifstream file(file_path, ios::binary);
+        if(!file){
+            std::cout << "\033[33m[WARN] The file \"" << file_path << "\" does NOT exist.\033[00m" << std::endl;
+            return;
+        }
+        std::cout << "\033[32m[INFO] Parsing \"" << file_path << "\".\033[00m" << std::endl;
+        string buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        vector<ASNumber> new_as_list;
+        vector<Connection> new_connection_list;
+        size_t line_number = 0, invalid_line_num = 0;
+        size_t line_begin = 0;
+        while(line_begin < buffer.size()){
+            size_t line_end = buffer.find('\n', line_begin);
+            if(line_end == string::npos){
+                line_end = buffer.size();
+            }
+            string_view line(buffer.data() + line_begin, line_end - line_begin);
+            line_begin = line_end + 1;
+            ++line_number;
+            if(!line.empty() && line.back() == '\r'){
+                line.remove_suffix(1);
+            }
+            if(line.empty() || line.front() == '#'){
+                continue;
+            }
+
+            // AS1 | AS2 | rel [| source]
+            ASNumber field[3];
+            const char* p = line.data();
+            const char* end = line.data() + line.size();
+            bool valid = true;
+            for(int i = 0; i < 3 && valid; ++i){
+                auto result = from_chars(p, end, field[i]);
+                valid = result.ec == errc{} && (i == 2 ? (result.ptr == end || *result.ptr == '|') : (result.ptr != end && *result.ptr == '|'));
+                p = result.ptr + 1;
+            }
+            if(!valid || field[0] == 0 || field[1] == 0 || field[0] == field[1] || !(field[2] == -1 || field[2] == 0)){
+                if(invalid_line_num++ == 0){
+                    std::cout << "\033[33m[WARN] Line " << line_number << " of \"" << file_path << "\" is NOT a valid AS relationship, and ignored.\033[00m" << std::endl;
+                }
+                continue;
+            }
+            new_as_list.push_back(field[0]);
+            new_as_list.push_back(field[1]);
+            new_connection_list.push_back(Connection{field[2] == -1 ? ConnectionType::Down : ConnectionType::Peer, field[0], field[1]});
+        }
+        if(1 < invalid_line_num){
+            std::cout << "\033[33m[WARN] " << invalid_line_num << " lines in total were ignored.\033[00m" << std::endl;
+        }
 
+        /* AS LIST (in ascending order of AS number) */
+        sort(new_as_list.begin(), new_as_list.end());
+        new_as_list.erase(unique(new_as_list.begin(), new_as_list.end()), new_as_list.end());
+        new_as_list.erase(remove_if(new_as_list.begin(), new_as_list.end(), [&](ASNumber as_number){
+            return as_class_list.class_list.count(as_number) != 0;
+        }), new_as_list.end());
+        size_t added_as_num = add_ASes(new_as_list);
+
+        /* CONNECTION LIST */
+        size_t added_connection_num = add_connections(new_connection_list);
+        std::cout << "\033[32m[INFO] " << added_as_num << " AS and " << added_connection_num << " connections were added.\033[00m" << std::endl;
+        return;
+    }
+
+    void file_export(string file_path_string, bool parallel=true){
+        // The file is written AS by AS without building the document tree (the text is the same as YAML::Emitter).
+        // If parallel is true, the routing tables are formatted in parallel.
         filesystem::path file_path(file_path_string);
 
         // if (filesystem::exists(file_path)) {
@@ -421,32 +1383,17 @@ public:
         //     }
         // }
 
-        /* AS LIST */
-        for(const auto& it : YAML::convert<ASClassList>::encode(as_class_list)){
-            export_data[it.first] = it.second;
-        }
-        /* CONNECTION LIST */
-        export_data["connection"] = connection_list;
-
-        /* MESSAGES LIST */
-        export_data["message"] = message_queue;
-
-        /* SECURITY OBJECTS */
-        export_data["ASPA"] = public_aspa_list;
-        export_data["isec_adopted_as_list"] = isec_adopted_as_list;
-        export_data["public_ProConID"] = public_ProConID;
-
         std::ofstream fout(file_path_string);
         if (!fout) {
             std::cerr << "\033[33m[WARN] Failed to open the file \"" << file_path_string << "\" for writing.\033[00m\n";
             return;
         }
 
-        YAML::Emitter out;
-        out.SetIndent(1);
-        out << export_data;
-        fout << out.c_str();
+        LOTUSYAMLWriter::write(fout, as_class_list, connection_list, message_queue, public_aspa_list, isec_adopted_as_list, public_ProConID, parallel);
         fout.close();
+        if(!fout){
+            std::cerr << "\033[33m[WARN] Failed to write the file \"" << file_path_string << "\".\033[00m\n";
+        }
 
         return;
     }
@@ -481,6 +1428,191 @@ public:
         return;
     }
 
+    void gen_subprefix_attack(ASNumber src, ASNumber target, int prefix_length){
+        // The same attack as gen_attack(), on the more specific prefix (of <prefix_length>) at the beginning of the network of <target>.
+        // The hijacked packets are then found by the longest prefix match (see get_forwarding_result()).
+        ASClass* target_as_class = get_AS(target);
+        if(get_AS(src) == nullptr || target_as_class == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << (get_AS(src) == nullptr ? src : target) << " has NOT been registered, no attack has been generated.\033[00m" << std::endl;
+            return;
+        }
+        const IPAddress& target_prefix = target_as_class->network_address;
+        if(prefix_length <= target_prefix.length || 32 < prefix_length){
+            std::cout << "\033[33m[WARN] The network " << target_prefix << " of AS " << target << " has no sub-prefix of length " << prefix_length << ", no attack has been generated.\033[00m" << std::endl;
+            return;
+        }
+        IPAddress subprefix = IPv4Prefix{target_prefix.address, prefix_length};
+        Path attack_path = Path{target, src};
+        for(const Connection& c : get_connection_with(src)){
+            add_messages(MessageType::Update, src, (src == c.src) ? c.dst : c.src, subprefix, attack_path);
+        }
+        return;
+    }
+
+    void add_prefix(ASNumber as_number, const string& network_string){
+        // The AS originates <network> (an IPv4 prefix) in addition to its network address.
+        // It is advertised by the Init messages, as the network address is.
+        ASClass* as_class = get_AS(as_number);
+        if(as_class == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered, the prefix CANNOT be added.\033[00m" << std::endl;
+            return;
+        }
+        optional<IPv4Prefix> prefix = parse_IPv4_prefix(network_string);
+        if(!prefix){
+            std::cout << "\033[33m[WARN] \"" << network_string << "\" is NOT an IPv4 prefix, the prefix was NOT added.\033[00m" << std::endl;
+            return;
+        }
+        const IPAddress network = *prefix;
+        if(contains(as_class->routing_table.get_origin_network_list(), network)){
+            std::cout << "\033[33m[WARN] AS " << as_number << " already originates " << network << ".\033[00m" << std::endl;
+            return;
+        }
+        as_class->routing_table.add_origin(network);
+        transit_index_outdated = true;
+        return;
+    }
+
+    vector<IPAddress> get_prefix_list(ASNumber as_number){
+        // The networks originated by the AS (including its network address).
+        ASClass* as_class = get_AS(as_number);
+        if(as_class == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered.\033[00m" << std::endl;
+            return {};
+        }
+        return as_class->routing_table.get_origin_network_list();
+    }
+
+
+    void add_hijack_watch(ASNumber attacker, ASNumber target){
+        // From the next run(), the number of AS whose best path to the network of <target> traverses or originates at <attacker>
+        // is maintained on each change of a best path (see get_hijack_impact()).
+        if(get_AS(attacker) == nullptr || get_AS(target) == nullptr){
+            std::cout << "\033[33m[WARN] Since AS " << (get_AS(attacker) == nullptr ? attacker : target) << " has NOT been registered, the hijack CANNOT be watched.\033[00m" << std::endl;
+            return;
+        }
+        if(find_hijack_watch(attacker, target) != nullptr){
+            std::cout << "\033[33m[WARN] The hijack of AS " << target << " by AS " << attacker << " is already watched.\033[00m" << std::endl;
+            return;
+        }
+        HijackWatch watch{attacker, target, get_AS(target)->network_address};
+        watch.initialize(as_class_list);
+        hijack_watch_list.push_back(watch);
+        return;
+    }
+
+    void remove_hijack_watch(ASNumber attacker, ASNumber target){
+        hijack_watch_list.erase(remove_if(hijack_watch_list.begin(), hijack_watch_list.end(), [&](const HijackWatch& watch){
+            return watch.attacker == attacker && watch.target == target;
+        }), hijack_watch_list.end());
+        return;
+    }
+
+    size_t get_hijack_impact(ASNumber attacker, ASNumber target){
+        const HijackWatch* watch = find_hijack_watch(attacker, target);
+        if(watch == nullptr){
+            std::cout << "\033[33m[WARN] The hijack of AS " << target << " by AS " << attacker << " is NOT watched.\033[00m" << std::endl;
+            return 0;
+        }
+        return watch->count;
+    }
+
+    vector<pair<size_t, size_t>> get_hijack_impact_history(ASNumber attacker, ASNumber target){
+        // (number of processed messages in the last run(), impact) on each change of the impact.
+        const HijackWatch* watch = find_hijack_watch(attacker, target);
+        if(watch == nullptr){
+            std::cout << "\033[33m[WARN] The hijack of AS " << target << " by AS " << attacker << " is NOT watched.\033[00m" << std::endl;
+            return {};
+        }
+        return watch->history;
+    }
+
+    void show_hijack_impact(void){
+        std::cout << "--------------------" << "\n";
+        std::cout << "HIJACK IMPACT" << '\n';
+        for(const HijackWatch& watch : hijack_watch_list){
+            std::cout << "  - \033[1mattacker\033[0m : " << watch.attacker << ", \033[1mtarget\033[0m : " << watch.target;
+            std::cout << " (" << watch.network << "), \033[1mimpact\033[0m : " << watch.count << " / " << as_class_list.class_list.size() << " AS\n";
+        }
+        std::cout << "--------------------" << "\n";
+    }
+
+    const HijackWatch* find_hijack_watch(ASNumber attacker, ASNumber target) const {
+        for(const HijackWatch& watch : hijack_watch_list){
+            if(watch.attacker == attacker && watch.target == target){
+                return &watch;
+            }
+        }
+        return nullptr;
+    }
+
+    void set_transit_index(bool onoff){
+        // If true, the number of best paths crossing each AS is maintained by run() (see get_transit_count()).
+        if(onoff && !transit_index){
+            transit_index.emplace();
+            transit_index_outdated = true;
+        }else if(!onoff){
+            transit_index = nullopt;
+        }
+        return;
+    }
+
+    const TransitIndex& get_transit_index(void){
+        // The index is rebuilt from the routing tables only when it has been enabled or the tables have been imported since.
+        if(!transit_index){
+            throw logic_error("\n\033[31m[ERROR] The transit index is NOT enabled (use set_transit_index(true)): " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        if(transit_index_outdated){
+            transit_index->build(as_class_list);
+            transit_index_outdated = false;
+        }
+        return *transit_index;
+    }
+
+    size_t get_transit_count(ASNumber transit_as){
+        // The number of best paths (of all AS to all networks) crossing <transit_as>.
+        if(!transit_index){
+            std::cout << "\033[33m[WARN] The transit index is NOT enabled (use set_transit_index(true)).\033[00m" << std::endl;
+            return 0;
+        }
+        return get_transit_index().get_count(transit_as);
+    }
+
+    size_t get_transit_count(ASNumber transit_as, const IPAddress& network){
+        // The number of AS whose best path to <network> crosses <transit_as>.
+        if(!transit_index){
+            std::cout << "\033[33m[WARN] The transit index is NOT enabled (use set_transit_index(true)).\033[00m" << std::endl;
+            return 0;
+        }
+        return get_transit_index().get_count(transit_as, network);
+    }
+
+    vector<ASNumber> get_transit_dependents(ASNumber transit_as, const IPAddress& network){
+        // The AS whose best path to <network> crosses <transit_as> (the routing tables are scanned).
+        vector<ASNumber> as_list;
+        Path path;
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            if(it->second.routing_table.get_best_path(network, path) && 1 < path.size() && find(path.begin() + 1, path.end(), variant<ASNumber, Itself>(transit_as)) != path.end()){
+                as_list.push_back(it->first);
+            }
+        }
+        return as_list;
+    }
+
+    vector<pair<ASNumber, size_t>> get_top_transit_list(size_t num){
+        // <num> AS crossed by the largest numbers of best paths (ties in ascending order of AS number).
+        if(!transit_index){
+            std::cout << "\033[33m[WARN] The transit index is NOT enabled (use set_transit_index(true)).\033[00m" << std::endl;
+            return {};
+        }
+        const TransitIndex& index = get_transit_index();
+        vector<pair<ASNumber, size_t>> transit_list(index.total.begin(), index.total.end());
+        num = min(num, transit_list.size());
+        partial_sort(transit_list.begin(), transit_list.begin() + num, transit_list.end(), [](const auto& x, const auto& y){
+            return x.second != y.second ? x.second > y.second : x.first < y.first;
+        });
+        transit_list.resize(num);
+        return transit_list;
+    }
 
     // SECURITY OBJECTS
     void add_ASPA(ASNumber customer, vector<ASNumber> provider_list){
@@ -488,35 +1620,82 @@ public:
     }
 
     void auto_ASPA(ASNumber origin_customer, int hop_num){
+        // Generates the ASPA of the customer and of its providers up to <hop_num> hops (a negative value means no limit).
         ASClass* customer_as_class = get_AS(origin_customer);
         if(customer_as_class == nullptr){
             std::cout << "\033[33m[WARN] Since AS " << origin_customer << " has NOT been registered, the ASPA CANNOT be added.\033[00m" << std::endl;
             return;
         }
-        vector<ASNumber> customer_as_list = {origin_customer};
+        const ASGraph& graph = get_as_graph();
+        const int origin_id = graph.get_id(origin_customer);
+        if(origin_id < 0){
+            std::cout << "\033[33m[WARN] Since AS " << origin_customer << " is NOT on the AS graph, the ASPA CANNOT be added.\033[00m" << std::endl;
+            return;
+        }
+        vector<char> checked(graph.size(), 0);
+        vector<int> customer_id_list = {origin_id};
+        vector<ASNumber> customer_as_list = {};
+        checked[origin_id] = 1;
 
-        while(hop_num != 0 && customer_as_list.size() != 0){
-            vector<ASNumber> next_customer_as_list = {};
-            for(ASNumber& customer : customer_as_list){
-                vector<Connection> c_list = get_connection_with(customer);
-                vector<ASNumber> provider_list = {};
-                for(const Connection& connection : c_list){
-                    if(as_a_is_what_on_c(customer, connection) == ComeFrom::Customer){
-                        provider_list.push_back(connection.src);
+        while(hop_num != 0 && customer_id_list.size() != 0){
+            vector<int> next_customer_id_list = {};
+            for(const int customer : customer_id_list){
+                customer_as_list.push_back(graph.as_number_list[customer]);
+                for(const int provider : graph.providers.of(customer)){
+                    if(!checked[provider]){
+                        checked[provider] = 1;
+                        next_customer_id_list.push_back(provider);
                     }
                 }
-                next_customer_as_list.insert(next_customer_as_list.end(), provider_list.begin(), provider_list.end());
-                if(provider_list.size() == 0){
-                    public_aspa_list[customer] = {0};
-                }else{
-                    public_aspa_list[customer] = provider_list;
-                }
             }
             hop_num -= 1;
-            sort(customer_as_list.begin(), customer_as_list.end());
-            sort(next_customer_as_list.begin(), next_customer_as_list.end());
-            set_union(customer_as_list.begin(), customer_as_list.end(), next_customer_as_list.begin(), next_customer_as_list.end(), back_inserter(customer_as_list));
+            customer_id_list = move(next_customer_id_list);
+        }
+        auto_ASPA_list(customer_as_list);
+        return;
+    }
+
+    void auto_ASPA_list(const vector<ASNumber>& customer_as_list){
+        // Generates the ASPA of every given customer from its providers on the connection list.
+        // An AS without any provider publishes the ASPA {0}.
+        const ASGraph& graph = get_as_graph();
+        vector<vector<ASNumber>> provider_list(customer_as_list.size());
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(size_t i = 0; i < customer_as_list.size(); ++i){
+            int id = graph.get_id(customer_as_list[i]);
+            if(id >= 0){
+                for(const int provider : graph.providers.of(id)){
+                    provider_list[i].push_back(graph.as_number_list[provider]);
+                }
+            }
+            if(provider_list[i].size() == 0){
+                provider_list[i] = {0};
+            }
         }
+        for(size_t i = 0; i < customer_as_list.size(); ++i){
+            public_aspa_list[customer_as_list[i]] = move(provider_list[i]);
+        }
+        return;
+    }
+
+    void auto_ASPA_all(void){
+        vector<ASNumber> customer_as_list;
+        customer_as_list.reserve(as_class_list.class_list.size());
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            customer_as_list.push_back(it->first);
+        }
+        auto_ASPA_list(customer_as_list);
+        return;
+    }
+
+    void auto_ASPA_random(double adoption_rate, unsigned int seed){
+        auto_ASPA_list(get_random_AS_list(adoption_rate, seed));
+        return;
+    }
+
+    void auto_ASPA_tier(int tier){
+        auto_ASPA_list(get_tier_AS_list(tier));
+        return;
     }
 
     void set_ASPV(ASNumber as_number, bool onoff, int priority){
@@ -554,48 +1733,124 @@ public:
     }
 
     void add_ProConID_all(void){
+        // ProConID of an adopting AS is the set of adopting AS reachable by going up its providers,
+        // passing only through NON adopting AS.
+        // Instead of searching from every adopting AS, the reachable sets of the NON adopting AS are computed once,
+        // going down the provider DAG (the provider cycles are collapsed into their strongly connected components).
+        const ASGraph& graph = get_as_graph();
+        const int n = static_cast<int>(graph.size());
+        vector<char> adopted(n, 0);
         for(const ASNumber as_number : isec_adopted_as_list){
-            vector<ASNumber> ProConID_list = {};
-            vector<ASNumber> provider_list = {as_number};
-            vector<ASNumber> checked_list = {};
-
-            while(0 < provider_list.size()){
-                ASNumber customer = provider_list.front();
-                provider_list.erase(provider_list.begin());
-                if(contains(checked_list, customer)){
-                    continue;
-                }
-                checked_list.push_back(customer);
+            int id = graph.get_id(as_number);
+            if(id >= 0){
+                adopted[id] = 1;
+            }
+        }
+        vector<char> not_adopted(n);
+        for(int id = 0; id < n; ++id){
+            not_adopted[id] = !adopted[id];
+        }
 
-                vector<ASNumber> next_provider_list = {};
+        int scc_num;
+        const vector<int> component = graph.provider_scc(not_adopted, scc_num);
+        vector<vector<int>> member(scc_num);
+        for(int id = 0; id < n; ++id){
+            if(component[id] >= 0){
+                member[component[id]].push_back(id);
+            }
+        }
+
+        // Components are processed level by level, where every provider component has a lower level.
+        vector<int> level(scc_num, 0);
+        int max_level = 0;
+        for(int scc = 0; scc < scc_num; ++scc){
+            for(const int id : member[scc]){
+                for(const int provider : graph.providers.of(id)){
+                    if(component[provider] >= 0 && component[provider] != scc){
+                        level[scc] = max(level[scc], level[component[provider]] + 1);
+                    }
+                }
+            }
+            max_level = max(max_level, level[scc]);
+        }
+        vector<vector<int>> level_list(max_level + 1);
+        for(int scc = 0; scc < scc_num; ++scc){
+            level_list[level[scc]].push_back(scc);
+        }
 
-                vector<Connection> c_list = get_connection_with(customer);
-                for(const Connection& connection : c_list){
-                    if(as_a_is_what_on_c(customer, connection) == ComeFrom::Customer){
-                        next_provider_list.push_back(connection.src);
+        // Reachable adopting AS (sorted dense ids). Components with the same set share it.
+        vector<shared_ptr<const vector<int>>> reachable(scc_num);
+        const shared_ptr<const vector<int>> empty_set = make_shared<const vector<int>>();
+        auto collect = [&](const IdRange& provider_list, int self_scc, vector<int>& buffer) -> shared_ptr<const vector<int>> {
+            buffer.clear();
+            shared_ptr<const vector<int>> only_source = nullptr;
+            int source_num = 0;
+            for(const int provider : provider_list){
+                if(adopted[provider]){
+                    buffer.push_back(provider);
+                    source_num = 2;
+                }else if(component[provider] != self_scc && !reachable[component[provider]]->empty()){
+                    const vector<int>& r = *reachable[component[provider]];
+                    buffer.insert(buffer.end(), r.begin(), r.end());
+                    if(source_num == 0 || only_source != reachable[component[provider]]){
+                        only_source = reachable[component[provider]];
+                        source_num += 1;
                     }
                 }
+            }
+            if(source_num == 0){
+                return empty_set;
+            }else if(source_num == 1){
+                return only_source;
+            }
+            sort(buffer.begin(), buffer.end());
+            buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+            return make_shared<const vector<int>>(buffer);
+        };
 
-                for(auto it = next_provider_list.begin(); it != next_provider_list.end();){
-                    if(contains(ProConID_list, *it) || contains(checked_list, *it)){
-                        it = next_provider_list.erase(it);
+        for(const vector<int>& scc_list : level_list){
+            #pragma omp parallel
+            {
+                vector<int> buffer, merged;
+                #pragma omp for schedule(dynamic, 64)
+                for(size_t i = 0; i < scc_list.size(); ++i){
+                    const int scc = scc_list[i];
+                    if(member[scc].size() == 1){
+                        reachable[scc] = collect(graph.providers.of(member[scc].front()), scc, buffer);
                         continue;
                     }
-                    if(find(isec_adopted_as_list.begin(), isec_adopted_as_list.end(), *it) != isec_adopted_as_list.end()){
-                        ProConID_list.push_back(*it);
-                        it = next_provider_list.erase(it);
-                    }else{
-                        ++it;
+                    merged.clear();
+                    for(const int id : member[scc]){
+                        shared_ptr<const vector<int>> r = collect(graph.providers.of(id), scc, buffer);
+                        merged.insert(merged.end(), r->begin(), r->end());
                     }
+                    sort(merged.begin(), merged.end());
+                    merged.erase(unique(merged.begin(), merged.end()), merged.end());
+                    reachable[scc] = make_shared<const vector<int>>(merged);
                 }
+            }
+        }
 
-                // here, next_provider_list is the list of NON adopting provider as.
-                sort(next_provider_list.begin(), next_provider_list.end());
-                sort(provider_list.begin(), provider_list.end());
-                set_union(provider_list.begin(), provider_list.end(), next_provider_list.begin(), next_provider_list.end(), back_inserter(provider_list));
-                provider_list.erase(unique(provider_list.begin(), provider_list.end()), provider_list.end());
+        vector<vector<ASNumber>> ProConID_list(isec_adopted_as_list.size());
+        #pragma omp parallel
+        {
+            vector<int> buffer;
+            #pragma omp for schedule(dynamic, 64)
+            for(size_t i = 0; i < isec_adopted_as_list.size(); ++i){
+                int id = graph.get_id(isec_adopted_as_list[i]);
+                if(id < 0){
+                    continue;
+                }
+                shared_ptr<const vector<int>> r = collect(graph.providers.of(id), -1, buffer);
+                for(const int reachable_id : *r){
+                    if(reachable_id != id){
+                        ProConID_list[i].push_back(graph.as_number_list[reachable_id]);
+                    }
+                }
             }
-            public_ProConID[as_number] = ProConID_list;
+        }
+        for(size_t i = 0; i < isec_adopted_as_list.size(); ++i){
+            public_ProConID[isec_adopted_as_list[i]] = move(ProConID_list[i]);
         }
         return;
     }
@@ -622,3 +1877,6 @@ public:
         return;
     }
 };
+
+#include "scenario.h"
+#include "daemon.h"
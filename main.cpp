@@ -120,9 +120,9 @@ int main() {
     /* ADD INIT MESSAGE TO ALL AS */
     LOTUS.add_all_init();
 
-    test_normal(LOTUS);
-    test_aspa(LOTUS);
-    test_isec(LOTUS);
+    test_normal(LOTUS.fork());
+    test_aspa(LOTUS.fork());
+    test_isec(LOTUS.fork());
 
     return 0;
 }
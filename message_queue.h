@@ -0,0 +1,461 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+/***
+ *** The FIFO queue of the messages of LOTUS, whose memory can be limited by set_memory_limit().
+ *** A message is kept as a PackedMessage of 16 bytes, whose network is an index of network_list and whose path is kept in
+ *** the path list next to it (in the same order as the messages). Message is made only by get_front() and for_each().
+ *** The messages are kept in three parts, in this order:
+ ***   - head    : in memory, popped from the front (and pushed to the back while the others are empty).
+ ***   - segments: on a file, as the PackedMessage and the path of each message (the oldest segment is read back into the head).
+ ***   - tail    : in memory, pushed to the back. It is written to the file as a segment when it exceeds half of the limit.
+ *** The file is removed when it is opened, thus it is never left even if the process is killed.
+ ***/
+
+const size_t RING_BUFFER_MIN_CAPACITY = 1024;
+
+template <typename T>
+class RingBuffer{
+    // A FIFO buffer of trivially copyable values, whose capacity is a power of two. The capacity is halved when a quarter
+    // of it is used, thus the memory of a drained queue is released.
+    vector<T> buffer;
+    size_t begin = 0;
+    size_t count = 0;
+
+public:
+    bool empty(void) const {
+        return count == 0;
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+
+    const T& front(void) const {
+        return buffer[begin];
+    }
+
+    const T& operator[](size_t i) const {
+        return buffer[(begin + i) & (buffer.size() - 1)];
+    }
+
+    void push_back(const T& value){
+        if(count == buffer.size()){
+            grow();
+        }
+        buffer[(begin + count) & (buffer.size() - 1)] = value;
+        count++;
+    }
+
+    void pop_front(size_t n=1){
+        begin = (begin + n) & (buffer.size() - 1);
+        count -= n;
+        if(RING_BUFFER_MIN_CAPACITY < buffer.size() && count < buffer.size() / 4){
+            resize(buffer.size() / 2);
+        }
+    }
+
+    void clear(void){
+        begin = 0;
+        count = 0;
+    }
+
+private:
+    void grow(void){
+        resize(max(RING_BUFFER_MIN_CAPACITY, buffer.size() * 2));
+    }
+
+    void resize(size_t capacity){
+        vector<T> resized(capacity);
+        for(size_t i = 0; i < count; ++i){
+            resized[i] = (*this)[i];
+        }
+        buffer.swap(resized);
+        begin = 0;
+    }
+};
+
+struct PackedMessage{
+    ASNumber src;
+    ASNumber dst;
+    uint32_t network_id;   // MessageQueue::NO_NETWORK if the message has no network
+    uint16_t path_length;
+    uint8_t type;
+    uint8_t flags;         // bit 0: path, bit 1: dst, bit 2: come_from, bits 4-5: the value of come_from
+};
+static_assert(sizeof(PackedMessage) == 16);
+
+struct MessageBlock{
+    RingBuffer<PackedMessage> message_list;
+    RingBuffer<ASNumber> path_list;  // the paths of message_list in order (ITSELF_AS_NUMBER for Itself)
+
+    size_t bytes(void) const {
+        return message_list.size() * sizeof(PackedMessage) + path_list.size() * sizeof(ASNumber);
+    }
+
+    void clear(void){
+        message_list.clear();
+        path_list.clear();
+    }
+};
+
+class MessageQueue{
+public:
+    static const uint32_t NO_NETWORK = UINT32_MAX;
+
+private:
+    MessageBlock head;
+    MessageBlock tail;
+    deque<pair<off_t, size_t>> segment_list;   // (offset, number of messages) on the file
+    size_t spilled_num = 0;                    // messages in segment_list
+    uint64_t push_num = 0;                     // messages pushed since the queue was made (not reset by clear())
+    size_t memory_limit = 0;                   // bytes (0: no limit)
+    string spill_directory;
+    int spill_fd = -1;
+    off_t spill_size = 0;
+    vector<IPAddress> network_list;
+    unordered_map<IPAddress, uint32_t> network_index;
+
+public:
+    MessageQueue(void){}
+
+    MessageQueue(const MessageQueue& other){
+        *this = other;
+    }
+
+    MessageQueue(MessageQueue&& other){
+        *this = std::move(other);
+    }
+
+    ~MessageQueue(void){
+        close_spill_file();
+    }
+
+    MessageQueue& operator=(const MessageQueue& other){
+        // The copy has its own file (if needed) with the same limit.
+        if(this == &other){
+            return *this;
+        }
+        clear();
+        memory_limit = other.memory_limit;
+        spill_directory = other.spill_directory;
+        if(other.segment_list.empty()){
+            head = other.head;
+            tail = other.tail;
+            network_list = other.network_list;
+            network_index = other.network_index;
+        }else{
+            other.for_each([&](const Message& msg){
+                push(msg);
+            });
+        }
+        push_num = other.push_num;
+        return *this;
+    }
+
+    MessageQueue& operator=(MessageQueue&& other){
+        if(this == &other){
+            return *this;
+        }
+        close_spill_file();
+        head = std::move(other.head);
+        tail = std::move(other.tail);
+        segment_list = std::move(other.segment_list);
+        spilled_num = other.spilled_num;
+        push_num = other.push_num;
+        memory_limit = other.memory_limit;
+        spill_directory = std::move(other.spill_directory);
+        spill_fd = other.spill_fd;
+        spill_size = other.spill_size;
+        network_list = std::move(other.network_list);
+        network_index = std::move(other.network_index);
+        other.head.clear();
+        other.tail.clear();
+        other.segment_list.clear();
+        other.spilled_num = 0;
+        other.spill_fd = -1;
+        other.spill_size = 0;
+        other.network_list.clear();
+        other.network_index.clear();
+        return *this;
+    }
+
+    void set_memory_limit(size_t bytes, const string& directory){
+        // The messages over <bytes> are written to a file in <directory>. 0 removes the limit (the messages on the file are kept).
+        memory_limit = bytes;
+        spill_directory = directory;
+        if(0 < memory_limit && memory_limit < 2 * tail.bytes()){
+            spill_tail();
+        }
+    }
+
+    size_t get_memory_limit(void) const {
+        return memory_limit;
+    }
+
+    const string& get_spill_directory(void) const {
+        return spill_directory;
+    }
+
+    bool empty(void) const {
+        // The head is empty only if the whole queue is empty.
+        return head.message_list.empty();
+    }
+
+    size_t size(void) const {
+        return head.message_list.size() + spilled_num + tail.message_list.size();
+    }
+
+    size_t spilled_size(void) const {
+        return spilled_num;
+    }
+
+    uint64_t get_push_num(void) const {
+        // The messages pushed so far, thus the last (get_push_num() - n) messages (if still queued) were pushed since it was n.
+        return push_num;
+    }
+
+    void get_front(Message& msg) const {
+        // The front is decoded into <msg>, whose memory is reused.
+        decode(head.message_list.front(), head.path_list, 0, msg);
+    }
+
+    uint32_t get_front_network_id(void) const {
+        return head.message_list.front().network_id;
+    }
+
+    const IPAddress& get_network(uint32_t network_id) const {
+        // The ids are valid until clear().
+        return network_list[network_id];
+    }
+
+    uint32_t get_network_id(const IPAddress& network){
+        auto [it, inserted] = network_index.try_emplace(network, network_list.size());
+        if(inserted){
+            network_list.push_back(network);
+        }
+        return it->second;
+    }
+
+    void push(const Message& msg){
+        PackedMessage packed = {msg.src, msg.dst.value_or(0), msg.address ? get_network_id(*msg.address) : NO_NETWORK, 0, static_cast<uint8_t>(msg.type), 0};
+        if(msg.dst){
+            packed.flags |= 2;
+        }
+        if(msg.come_from){
+            packed.flags |= 4 | (static_cast<uint8_t>(*msg.come_from) << 4);
+        }
+        if(msg.path){
+            push_packed(packed, *msg.path);
+        }else{
+            push_packed(packed, nullptr);
+        }
+    }
+
+    void push_update(ASNumber src, ASNumber dst, uint32_t network_id, const Path& path){
+        // An update message without come_from, without making a Message.
+        push_packed(PackedMessage{src, dst, network_id, 0, static_cast<uint8_t>(MessageType::Update), 2}, path);
+    }
+
+    void pop(void){
+        head.path_list.pop_front(head.message_list.front().path_length);
+        head.message_list.pop_front();
+        if(!head.message_list.empty()){
+            return;
+        }
+        if(!segment_list.empty()){
+            load_segment();
+        }else{
+            swap(head, tail);
+            if(0 < spill_size){
+                // No message on the file, which is reused from its beginning.
+                if(ftruncate(spill_fd, 0) == 0){
+                    spill_size = 0;
+                }
+            }
+        }
+    }
+
+    void clear(void){
+        head.clear();
+        tail.clear();
+        segment_list.clear();
+        spilled_num = 0;
+        network_list.clear();
+        network_index.clear();
+        close_spill_file();
+    }
+
+    template <typename Function>
+    void for_each(Function f, size_t first=0) const {
+        // f(const Message&) for the messages from the <first>-th one in FIFO order, without changing the queue.
+        // The messages before it are skipped without being decoded (a segment on the file without being read).
+        Message msg;
+        auto for_each_in = [&](const MessageBlock& block){
+            size_t path_begin = 0;
+            for(size_t i = 0; i < block.message_list.size(); ++i){
+                if(first == 0){
+                    decode(block.message_list[i], block.path_list, path_begin, msg);
+                    f(msg);
+                }else{
+                    --first;
+                }
+                path_begin += block.message_list[i].path_length;
+            }
+        };
+        for_each_in(head);
+        MessageBlock buffer;
+        for(const auto& [offset, message_num] : segment_list){
+            if(message_num <= first){
+                first -= message_num;
+                continue;
+            }
+            PipeReader reader(spill_fd, offset);
+            for(size_t i = 0; i < message_num; ++i){
+                buffer.clear();
+                const PackedMessage packed = read_packed(reader, buffer);
+                if(first == 0){
+                    decode(packed, buffer.path_list, 0, msg);
+                    f(msg);
+                }else{
+                    --first;
+                }
+            }
+        }
+        for_each_in(tail);
+    }
+
+    queue<Message> to_queue(void) const {
+        queue<Message> message_queue;
+        for_each([&](const Message& msg){
+            message_queue.push(msg);
+        });
+        return message_queue;
+    }
+
+private:
+    template <typename PathType>
+    void push_packed(PackedMessage packed, const PathType& path){
+        // The message goes to the head while nothing is behind it and the head is within the limit, otherwise to the tail.
+        // The references to the messages are not kept, thus the blocks may move their memory.
+        const bool to_head = segment_list.empty() && tail.message_list.empty() && (memory_limit == 0 || 2 * head.bytes() <= memory_limit);
+        MessageBlock& block = (to_head || head.message_list.empty()) ? head : tail;
+        if constexpr(!is_same_v<PathType, nullptr_t>){
+            if(UINT16_MAX < path.size()){
+                throw logic_error("\n\033[31m[ERROR] The path is too long (" + to_string(path.size()) + " AS): " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+            }
+            packed.flags |= 1;
+            packed.path_length = path.size();
+            for(const variant<ASNumber, Itself>& as_on_path : path){
+                const ASNumber* as_number = get_if<ASNumber>(&as_on_path);
+                block.path_list.push_back(as_number ? *as_number : ITSELF_AS_NUMBER);
+            }
+        }
+        block.message_list.push_back(packed);
+        push_num += 1;
+        if(&block == &tail && 0 < memory_limit && memory_limit < 2 * tail.bytes()){
+            spill_tail();
+        }
+    }
+
+    void decode(const PackedMessage& packed, const RingBuffer<ASNumber>& path_list, size_t path_begin, Message& msg) const {
+        msg.type = static_cast<MessageType>(packed.type);
+        msg.src = packed.src;
+        msg.dst = (packed.flags & 2) ? optional<ASNumber>(packed.dst) : nullopt;
+        if(packed.network_id == NO_NETWORK){
+            msg.address = nullopt;
+        }else{
+            msg.address = network_list[packed.network_id];
+        }
+        if(packed.flags & 1){
+            if(!msg.path){
+                msg.path.emplace();
+            }
+            msg.path->clear();
+            for(size_t i = 0; i < packed.path_length; ++i){
+                const ASNumber as_number = path_list[path_begin + i];
+                if(as_number == ITSELF_AS_NUMBER){
+                    msg.path->push_back(Itself::I);
+                }else{
+                    msg.path->push_back(as_number);
+                }
+            }
+        }else{
+            msg.path = nullopt;
+        }
+        msg.come_from = (packed.flags & 4) ? optional<ComeFrom>(static_cast<ComeFrom>((packed.flags >> 4) & 3)) : nullopt;
+    }
+
+    static PackedMessage read_packed(PipeReader& reader, MessageBlock& block){
+        // A message written by spill_tail(), whose path is added to <block>.
+        PackedMessage packed;
+        bool read = reader.read(packed);
+        for(size_t i = 0; read && i < packed.path_length; ++i){
+            ASNumber as_number;
+            read = reader.read(as_number);
+            block.path_list.push_back(as_number);
+        }
+        if(!read){
+            throw logic_error("\n\033[31m[ERROR] The spilled messages CANNOT be read: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        return packed;
+    }
+
+    void open_spill_file(void){
+        string path = (spill_directory.empty() ? filesystem::temp_directory_path().string() : spill_directory) + "/lotus_queue_XXXXXX";
+        spill_fd = mkstemp(path.data());
+        if(spill_fd < 0){
+            throw logic_error("\n\033[31m[ERROR] The spill file CANNOT be created in \"" + spill_directory + "\": " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        unlink(path.c_str());
+        fcntl(spill_fd, F_SETFL, fcntl(spill_fd, F_GETFL) | O_APPEND);
+        spill_size = 0;
+    }
+
+    void close_spill_file(void){
+        if(0 <= spill_fd){
+            close(spill_fd);
+        }
+        spill_fd = -1;
+        spill_size = 0;
+    }
+
+    void spill_tail(void){
+        if(tail.message_list.empty()){
+            return;
+        }
+        if(spill_fd < 0){
+            open_spill_file();
+        }
+        PipeWriter writer(spill_fd);
+        size_t path_begin = 0;
+        for(size_t i = 0; i < tail.message_list.size(); ++i){
+            const PackedMessage& packed = tail.message_list[i];
+            writer.write(packed);
+            for(size_t k = 0; k < packed.path_length; ++k){
+                writer.write(tail.path_list[path_begin + k]);
+            }
+            path_begin += packed.path_length;
+        }
+        const off_t offset = spill_size;
+        if(!writer.flush()){
+            throw logic_error("\n\033[31m[ERROR] The messages CANNOT be written to the spill file: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        spill_size = lseek(spill_fd, 0, SEEK_END);
+        segment_list.emplace_back(offset, tail.message_list.size());
+        spilled_num += tail.message_list.size();
+        tail.clear();
+    }
+
+    void load_segment(void){
+        const auto [offset, message_num] = segment_list.front();
+        PipeReader reader(spill_fd, offset);
+        for(size_t i = 0; i < message_num; ++i){
+            head.message_list.push_back(read_packed(reader, head));
+        }
+        segment_list.pop_front();
+        spilled_num -= message_num;
+    }
+};
+
+#endif
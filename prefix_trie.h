@@ -0,0 +1,100 @@
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+/***
+ *** Binary trie of IPv4 prefixes for the longest prefix match.
+ *** The nodes are stored on one array (12 bytes each), and a value (e.g. a network id) is kept on the node of each prefix.
+ ***/
+
+class PrefixTrie{
+public:
+    static constexpr int NONE = -1;
+
+    struct Node{
+        int child[2] = {NONE, NONE};
+        int value = NONE;
+    };
+    vector<Node> node_list = {Node{}};
+
+public:
+    void insert(const IPv4Prefix& prefix, int value){
+        int node = 0;
+        for(int depth = 0; depth < prefix.length; ++depth){
+            const int bit = (prefix.address >> (31 - depth)) & 1;
+            if(node_list[node].child[bit] == NONE){
+                node_list[node].child[bit] = static_cast<int>(node_list.size());
+                node_list.push_back(Node{});
+            }
+            node = node_list[node].child[bit];
+        }
+        node_list[node].value = value;
+    }
+
+    template <typename Function>
+    void for_each_match(const IPv4Prefix& destination, Function f) const {
+        // f(int value) for each prefix containing the destination, the longest first.
+        // If f returns true, the search stops.
+        int path[33];
+        int path_length = 0;
+        int node = 0;
+        for(int depth = 0; node != NONE; ++depth){
+            path[path_length++] = node;
+            if(depth == destination.length){
+                break;
+            }
+            node = node_list[node].child[(destination.address >> (31 - depth)) & 1];
+        }
+        for(int i = path_length - 1; i >= 0; --i){
+            if(node_list[path[i]].value != NONE && f(node_list[path[i]].value)){
+                return;
+            }
+        }
+    }
+
+    vector<IPv4Prefix> get_part_list(const IPv4Prefix& destination) const {
+        // The parts of the destination whose addresses have the same longest match: every prefix in the trie inside
+        // the destination, and the destination itself unless they cover all of its addresses (in ascending order).
+        vector<IPv4Prefix> part_list;
+        int node = 0;
+        for(int depth = 0; depth < destination.length && node != NONE; ++depth){
+            node = node_list[node].child[(destination.address >> (31 - depth)) & 1];
+        }
+        if(node == NONE){
+            return {destination};
+        }
+        if(!collect_part(node, destination, node, part_list)){
+            part_list.insert(part_list.begin(), destination);
+        }
+        return part_list;
+    }
+
+    int longest_match(const IPv4Prefix& destination) const {
+        int match = NONE;
+        for_each_match(destination, [&](int value){
+            match = value;
+            return true;
+        });
+        return match;
+    }
+
+private:
+    bool collect_part(int node, const IPv4Prefix& prefix, int top, vector<IPv4Prefix>& part_list) const {
+        // Adds the prefixes under <node> (except <top>) to the list, and returns whether they cover all of its addresses.
+        const bool is_part = node != top && node_list[node].value != NONE;
+        if(is_part){
+            part_list.push_back(prefix);
+        }
+        bool covered = true;
+        for(int bit = 0; bit < 2; ++bit){
+            const int child = node_list[node].child[bit];
+            if(child == NONE){
+                covered = false;
+            }else{
+                covered &= collect_part(child, IPv4Prefix{prefix.address | (static_cast<uint32_t>(bit) << (31 - prefix.length)), prefix.length + 1}, top, part_list);
+            }
+        }
+        return is_part || covered;
+    }
+};
+
+#endif
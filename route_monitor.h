@@ -0,0 +1,134 @@
+#ifndef ROUTE_MONITOR_H
+#define ROUTE_MONITOR_H
+
+/***
+ *** Counters maintained by LOTUS::run() on each change of a best path.
+ *** The previous best path is given as nullptr if the AS had no best path to the network.
+ ***/
+
+struct HijackWatch{
+    // The number of AS (except the attacker) whose best path to the network, or to any more specific prefix inside it,
+    // traverses or originates at the attacker (the packets to that part of the network are then hijacked by the longest prefix match).
+    ASNumber attacker;
+    ASNumber target;
+    IPAddress network;
+    size_t count = 0;
+    vector<pair<size_t, size_t>> history = {};  // (processed messages in the last run, count), on each change of the count
+    unordered_map<ASNumber, size_t> affected_num = {};  // AS -> number of its affected prefixes inside the network (0 if not on the map)
+
+    bool is_affected(ASNumber as_number, const Path& path) const {
+        return as_number != attacker && contains(path, attacker);
+    }
+
+    void initialize(ASClassList& as_class_list){
+        affected_num.clear();
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.for_each_best_route([&](const IPAddress& prefix, const Route& r){
+                if(network.contains(prefix) && is_affected(it->first, r.path)){
+                    ++affected_num[it->first];
+                }
+            });
+        }
+        count = affected_num.size();
+        history = {{0, count}};
+    }
+
+    void update(size_t processed_msg_num, ASNumber as_number, const Path* old_path, const Path& new_path){
+        // The best path of <as_number> to a prefix inside the network has been changed.
+        const bool was_affected = old_path != nullptr && is_affected(as_number, *old_path);
+        const bool is_now_affected = is_affected(as_number, new_path);
+        if(was_affected == is_now_affected){
+            return;
+        }
+        if(is_now_affected){
+            if(++affected_num[as_number] != 1){
+                return;
+            }
+            ++count;
+        }else{
+            auto it = affected_num.find(as_number);
+            if(--it->second != 0){
+                return;
+            }
+            affected_num.erase(it);
+            --count;
+        }
+        history.push_back({processed_msg_num, count});
+    }
+};
+
+class TransitIndex{
+    // The number of best paths crossing each AS, in total and for each network.
+    // The origin of a path is not a transit AS, while the neighbor advertising the route is.
+public:
+    unordered_map<IPAddress, uint32_t> network_id;
+    unordered_map<uint64_t, size_t> count;  // (transit AS, network id) -> number of AS whose best path crosses the transit AS
+    unordered_map<ASNumber, size_t> total;  // transit AS -> number of best paths crossing it
+
+public:
+    void build(const ASClassList& as_class_list){
+        count.clear();
+        total.clear();
+        for(auto it = as_class_list.class_list.begin(); it != as_class_list.class_list.end(); it++){
+            it->second.routing_table.for_each_best_route([&](const IPAddress& network, const Route& r){
+                add(network, r.path, 1);
+            });
+        }
+    }
+
+    void update(const IPAddress& network, const Path* old_path, const Path& new_path){
+        if(old_path != nullptr){
+            add(network, *old_path, -1);
+        }
+        add(network, new_path, 1);
+    }
+
+    size_t get_count(ASNumber transit) const {
+        auto it = total.find(transit);
+        return it == total.end() ? 0 : it->second;
+    }
+
+    size_t get_count(ASNumber transit, const IPAddress& network) const {
+        auto id = network_id.find(network);
+        if(id == network_id.end()){
+            return 0;
+        }
+        auto it = count.find(key(transit, id->second));
+        return it == count.end() ? 0 : it->second;
+    }
+
+private:
+    static uint64_t key(ASNumber transit, uint32_t id){
+        return (static_cast<uint64_t>(static_cast<uint32_t>(transit)) << 32) | id;
+    }
+
+    void add(const IPAddress& network, const Path& path, int diff){
+        if(path.size() < 2){
+            return;
+        }
+        const uint32_t id = network_id.try_emplace(network, static_cast<uint32_t>(network_id.size())).first->second;
+        for(size_t i = 1; i < path.size(); ++i){
+            const ASNumber* transit = get_if<ASNumber>(&path[i]);
+            if(transit == nullptr){
+                continue;
+            }
+            change(count, key(*transit, id), diff);
+            change(total, *transit, diff);
+        }
+    }
+
+    template <typename Key>
+    static void change(unordered_map<Key, size_t>& counter, const Key& k, int diff){
+        // The entries which become 0 are removed.
+        if(0 < diff){
+            counter[k] += diff;
+            return;
+        }
+        auto it = counter.find(k);
+        if(it != counter.end() && (it->second -= 1) == 0){
+            counter.erase(it);
+        }
+    }
+};
+
+#endif
@@ -2,69 +2,297 @@
 #define ROUTING_TABLE_H
 
 class RoutingTable{
+    // The blocks are kept in two layers, to share a converged table among forked LOTUS instances (copy-on-write).
+    //   - base_table : frozen blocks, shared with the forks (nullptr if none).
+    //   - table      : own blocks, which override the blocks of the same network on base_table.
+    // A block on base_table is copied to table when it is changed, thus only the changed networks are copied.
+    // Use for_each_block(), find_block() and get_block() instead of accessing the layers directly.
 public:
-    map<IPAddress, vector<Route*>> table;
+    shared_ptr<const map<IPAddress, RouteBlock>> base_table;
+    map<IPAddress, RouteBlock> table;
     vector<Policy> policy;
-    map<ASNumber, vector<ASNumber>> public_aspa_list;
-    vector<ASNumber> isec_adopted_as_list;
-    map<ASNumber, vector<ASNumber>> public_ProConID;
+    shared_ptr<const SecurityRegistry> security_registry = EMPTY_SECURITY_REGISTRY;
+    RibMode rib_mode = RibMode::Full;
+    size_t change_num = 0;  // incremented whenever update() changes a block
+    uint64_t length_set = 0;  // bit <l> is set if a network of the prefix length <l> is on either layer (see find_longest_match())
 
 public:
     RoutingTable() {}
     RoutingTable(vector<Policy> policy, const IPAddress network){
         this->policy = policy;
-        table[network] = {new Route{Path{{Itself::I}}, ComeFrom::Customer, 1000, true, nullopt, nullopt}};
+        add_origin(network);
     }
 
-    map<IPAddress, const Route*> get_best_route_list(void){
-        map<IPAddress, const Route*> best_route_list;
+    template <typename Function>
+    void for_each_block(Function f) const {
+        // f(const IPAddress& network, const RouteBlock& block) is called for every network, in the order of the network.
+        if(base_table == nullptr){
+            for(auto it = table.begin(); it != table.end(); it++){
+                f(it->first, it->second);
+            }
+            return;
+        }
+        auto base_it = base_table->begin();
+        auto own_it = table.begin();
+        while(base_it != base_table->end() || own_it != table.end()){
+            if(own_it == table.end() || (base_it != base_table->end() && base_it->first < own_it->first)){
+                f(base_it->first, base_it->second);
+                base_it++;
+            }else{
+                if(base_it != base_table->end() && base_it->first == own_it->first){
+                    base_it++;
+                }
+                f(own_it->first, own_it->second);
+                own_it++;
+            }
+        }
+    }
+
+    const RouteBlock* find_block(const IPAddress& network) const {
+        auto it = table.find(network);
+        if(it != table.end()){
+            return &it->second;
+        }
+        if(base_table != nullptr){
+            auto base_it = base_table->find(network);
+            if(base_it != base_table->end()){
+                return &base_it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    optional<IPAddress> find_longest_match(const IPAddress& destination) const {
+        // The longest network containing <destination> (an address as /32, or a prefix) to which the AS has a best route.
+        // Only the prefix lengths on length_set are looked up, thus it is at most 33 lookups of the table whatever its size.
+        for(int length = destination.length; 0 <= length; --length){
+            if(((length_set >> length) & 1) == 0){
+                continue;
+            }
+            const IPAddress network{destination.address & IPv4Prefix::mask(length), length};
+            const RouteBlock* block = find_block(network);
+            if(block != nullptr && block->get_best_index() >= 0){
+                return network;
+            }
+        }
+        return nullopt;
+    }
+
+    RouteBlock& get_block(const IPAddress& network){
+        // The own block of the network to be changed (copied from base_table, or added as an empty block).
+        length_set |= uint64_t{1} << network.length;
+        auto [it, inserted] = table.try_emplace(network);
+        if(inserted && base_table != nullptr){
+            auto base_it = base_table->find(network);
+            if(base_it != base_table->end()){
+                it->second = base_it->second;
+            }
+        }
+        return it->second;
+    }
+
+    bool empty(void) const {
+        return table.empty() && (base_table == nullptr || base_table->empty());
+    }
+
+    void clear(void){
+        base_table = nullptr;
+        table.clear();
+        length_set = 0;
+    }
+
+    template <typename Predicate>
+    void retain(Predicate keep){
+        // Only the networks for which keep(network) is true remain.
+        map<IPAddress, RouteBlock> kept_table;
+        length_set = 0;
+        for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            if(keep(network)){
+                kept_table.emplace(network, block);
+                length_set |= uint64_t{1} << network.length;
+            }
+        });
+        base_table = nullptr;
+        table = std::move(kept_table);
+    }
+
+    void share(void){
+        // Moves all blocks to base_table, to be shared with the copies of this table.
+        // The blocks changed since the last call are merged into a new base_table.
+        if(table.empty()){
+            return;
+        }
+        if(base_table == nullptr){
+            base_table = make_shared<const map<IPAddress, RouteBlock>>(std::move(table));
+        }else{
+            map<IPAddress, RouteBlock> merged_table = *base_table;
+            for(auto it = table.begin(); it != table.end(); it++){
+                merged_table[it->first] = std::move(it->second);
+            }
+            base_table = make_shared<const map<IPAddress, RouteBlock>>(std::move(merged_table));
+        }
+        table.clear();
+    }
 
-        for(auto it = table.begin(); it != table.end(); it++){
-            IPAddress address = it->first;
-            vector<Route*> route_list = it->second;
-            for(const Route* r : route_list){
-                if(r->best_path){
-                    best_route_list[address] = r;
+    void add_origin(const IPAddress& network){
+        // The route to a network originated by the AS itself (it replaces the received routes).
+        PackedRoute origin_route = {};
+        origin_route.come_from = static_cast<int>(ComeFrom::Customer);
+        origin_route.LocPrf    = static_cast<int>(LocPrfClass::Origin);
+        origin_route.best_path = true;
+        RouteBlock& block = table[network];  // the block on base_table (if any) is overridden
+        length_set |= uint64_t{1} << network.length;
+        block = RouteBlock{};
+        block.add_route(origin_route, ITSELF_VEC);
+    }
+
+    vector<IPAddress> get_origin_network_list(void) const {
+        // The networks originated by the AS itself.
+        vector<IPAddress> network_list;
+        for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            int best = block.get_best_index();
+            if(best >= 0 && block.route_list[best].LocPrf == static_cast<int>(LocPrfClass::Origin)){
+                network_list.push_back(network);
+            }
+        });
+        return network_list;
+    }
+
+    void set_rib_mode(RibMode rib_mode){
+        // RibMode::Full     : all received routes are kept.
+        // RibMode::BestOnly : only the best route of each network is kept.
+        //   Since a route which has lost is never compared again, the decision does not change.
+        //   A network without any best route is kept as an empty block, to remember that it has been received.
+        this->rib_mode = rib_mode;
+        if(rib_mode == RibMode::BestOnly){
+            vector<IPAddress> network_list;
+            for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                if(1 < block.size() || (block.size() == 1 && block.get_best_index() < 0)){
+                    network_list.push_back(network);
                 }
+            });
+            for(const IPAddress& network : network_list){
+                keep_best_only(get_block(network));
             }
         }
+    }
+
+    void keep_best_only(RouteBlock& block){
+        int best = block.get_best_index();
+        if(best < 0){
+            block = RouteBlock{};
+            return;
+        }
+        Path path;
+        block.get_path(best, path);
+        PackedRoute best_route = block.route_list[best];
+        block.route_list.clear();
+        block.path_list.clear();
+        block.add_route(best_route, path);
+        block.route_list.shrink_to_fit();
+        block.path_list.shrink_to_fit();
+    }
+
+    void add_route(const IPAddress& network, const Route& r){
+        // Adds the route as it is (used when importing). LocPrf is stored as its class.
+        PackedRoute packed_route = {};
+        optional<LocPrfClass> locprf_class = LocPrf_class(r.LocPrf);
+        if(locprf_class == nullopt){
+            std::cout << "\033[33m[WARN] LocPrf " << r.LocPrf << " is not a standard value, the value for \"" << r.come_from << "\" is used.\033[00m" << std::endl;
+            locprf_class = static_cast<LocPrfClass>(static_cast<int>(r.come_from) + 1);
+        }
+        packed_route.come_from = static_cast<int>(r.come_from);
+        packed_route.LocPrf    = static_cast<int>(*locprf_class);
+        packed_route.best_path = r.best_path;
+        packed_route.set_aspv(r.aspv);
+        packed_route.set_isec_v(r.isec_v);
+        RouteBlock& block = get_block(network);
+        block.add_route(packed_route, r.path);
+        if(rib_mode == RibMode::BestOnly){
+            keep_best_only(block);
+        }
+    }
+
+    template <typename Function>
+    void for_each_route(Function f) const {
+        // f(const IPAddress& network, const Route& r) is called for every route, in the order of the table.
+        Route r;
+        for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            for(size_t i = 0; i < block.size(); ++i){
+                block.get_route(i, r);
+                f(network, r);
+            }
+        });
+    }
 
+    template <typename Function>
+    void for_each_best_route(Function f) const {
+        // f(const IPAddress& network, const Route& r) is called for the best route of every network.
+        Route r;
+        for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            int best = block.get_best_index();
+            if(best >= 0){
+                block.get_route(best, r);
+                f(network, r);
+            }
+        });
+    }
+
+    map<IPAddress, Route> get_best_route_list(void) const {
+        map<IPAddress, Route> best_route_list;
+        for_each_best_route([&](const IPAddress& network, const Route& r){
+            best_route_list.emplace_hint(best_route_list.end(), network, r);
+        });
         return best_route_list;
     }
 
-    ASPV verify_pair(variant<ASNumber, Itself> customer, variant<ASNumber, Itself> provider){
-        auto it = public_aspa_list.find(get<ASNumber>(customer));
+    optional<Path> get_best_path(const IPAddress& network) const {
+        Path path;
+        if(get_best_path(network, path)){
+            return path;
+        }
+        return nullopt;
+    }
 
-        if(it == public_aspa_list.end()){
-            return ASPV::Unknown;
-        }else{
-            const vector<ASNumber>& provider_list = it->second;
-            if(find(provider_list.begin(), provider_list.end(), get<ASNumber>(provider)) != provider_list.end()){
-                return ASPV::Valid;
-            }else{
-                return ASPV::Invalid;
+    bool get_best_path(const IPAddress& network, Path& path) const {
+        // "path" is overwritten (its capacity can be reused), and false is returned if there is no best path.
+        const RouteBlock* block = find_block(network);
+        if(block != nullptr){
+            int best = block->get_best_index();
+            if(best >= 0){
+                block->get_path(best, path);
+                return true;
             }
         }
-        throw logic_error("\n\033[31m[ERROR] Unreachable code reached in function: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        path.clear();
+        return false;
+    }
+
+    ASPV verify_pair(variant<ASNumber, Itself> customer, variant<ASNumber, Itself> provider) const {
+        return security_registry->verify_pair(get<ASNumber>(customer), get<ASNumber>(provider));
+    }
+
+    ASPV aspv(const Route& r, ASNumber neighbor_as) const {
+        return aspv(r.path, r.come_from, neighbor_as);
     }
 
-    ASPV aspv(const Route r, ASNumber neighbor_as){
+    ASPV aspv(const Path& path, ComeFrom come_from, ASNumber neighbor_as) const {
         // The last node of the path of the route from another AS MUST NOT be Itself::I,
         // thus comparing only to ASNumber is enough.
 
         // Note: (I-D [https://datatracker.ietf.org/doc/draft-ietf-sidrops-aspa-verification/])
         // If there are no hops or just one hop between the apexes of the up-ramp and the down-ramp, then the AS_PATH is valid (valley free).
 
-        if(const ASNumber* p = get_if<ASNumber>(&r.path.back()); p && *p != neighbor_as){
+        if(const ASNumber* p = get_if<ASNumber>(&path.back()); p && *p != neighbor_as){
             return ASPV::Invalid;
         }
         ASPV semi_state = ASPV::Valid;
         ASPV pair_check;
-        switch(r.come_from){
+        switch(come_from){
             case ComeFrom::Customer:
             case ComeFrom::Peer:
-                for(size_t i = 0; i < r.path.size() - 1; ++i){
-                    pair_check = verify_pair(r.path[i], r.path[i+1]);
+                for(size_t i = 0; i < path.size() - 1; ++i){
+                    pair_check = verify_pair(path[i], path[i+1]);
                     if(pair_check == ASPV::Invalid){
                         return ASPV::Invalid;
                     }else if(pair_check == ASPV::Unknown){
@@ -74,18 +302,18 @@ public:
                 return semi_state;
             case ComeFrom::Provider:
                 bool upflow_fragment = true;
-                for(size_t i = 0; (upflow_fragment&&i<r.path.size()-1)||(!upflow_fragment&&i<r.path.size()); ++i){
+                for(size_t i = 0; (upflow_fragment&&i<path.size()-1)||(!upflow_fragment&&i<path.size()); ++i){
                     if(upflow_fragment){
-                        // r.path.size() <= i+1, IndexError
-                        pair_check = verify_pair(r.path[i], r.path[i+1]);
+                        // path.size() <= i+1, IndexError
+                        pair_check = verify_pair(path[i], path[i+1]);
                         if(pair_check == ASPV::Invalid){
                             upflow_fragment = false;
                         }else if(pair_check == ASPV::Unknown){
                             semi_state = ASPV::Unknown;
                         }
                     }else if(upflow_fragment == false){
-                        // if r.path.size() <= i, IndexError.
-                        pair_check = verify_pair(r.path[i], r.path[i-1]);
+                        // if path.size() <= i, IndexError.
+                        pair_check = verify_pair(path[i], path[i-1]);
                         if(pair_check == ASPV::Invalid){
                             return ASPV::Invalid;
                         }else if(pair_check == ASPV::Unknown){
@@ -98,51 +326,63 @@ public:
         throw logic_error("\n\033[31m[ERROR] Unreachable code reached in function: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
     }
 
-    optional<Isec> isec_v(const Route r, const Message update_msg){
+    optional<Isec> isec_v(const Message& update_msg) const {
+        if(update_msg.type == MessageType::Init){
+            return nullopt;
+        }
+        return isec_v(*security_registry, *update_msg.dst, *update_msg.path, *update_msg.come_from);
+    }
+
+    static ASNumber as_number_on_path(const variant<ASNumber, Itself>& as_on_path){
+        // The type of as_on_path MUST be ASNumber
+        return get<ASNumber>(as_on_path);
+    }
+
+    static ASNumber as_number_on_path(ASNumber as_on_path){
+        return as_on_path;
+    }
+
+    template <typename PathRange>
+    static optional<Isec> isec_v(const SecurityRegistry& registry, ASNumber receiver_as, const PathRange& path, ComeFrom come_from){
         // REFERENCE
         // C. Morris, A. Herzberg, B. Wang, and S. Secondo,
         // "BGP-iSec: Improved Security of Internet Routing Against Post-ROV Attacks",
         // in USENIX Network and Distributed System Security (NDSS) Symposium, 2024.
         // https://dx.doi.org/10.14722/ndss.2024.241035
 
-        // Origin = X0 -> X1 -> ... -> Xl -> Y = *update_msg.dst
-        // update_msg.path = {X0, X1, ..., Xl}, and Y is not included.
-
-        if(update_msg.type == MessageType::Init){
-            return nullopt;
-        }
+        // Origin = X0 -> X1 -> ... -> Xl -> Y = receiver_as
+        // path = {X0, X1, ..., Xl}, and Y is not included.
 
         // if the AS Y is not adopted AS, iSec should not evaluated.
-        if(!contains(isec_adopted_as_list, *update_msg.dst)){
+        const int receiver = registry.get_id(receiver_as);
+        if(!registry.is_isec_adopted(receiver)){
             return nullopt;
         }
 
         // If the origin AS does not adopted, iSec should not evaluated.
-        if(!contains(isec_adopted_as_list, get<ASNumber>((*update_msg.path).front()))){
+        if(!registry.is_isec_adopted(registry.get_id(as_number_on_path(*path.begin())))){
             return nullopt;
         }
 
-        if(update_msg.come_from == ComeFrom::Provider){
+        if(come_from == ComeFrom::Provider){
             return Isec::Valid;
         }else{
-            vector<ASNumber> adopted_path_as = {};
-            for(const auto as_number : *update_msg.path){
-                // The type of as_number MUST be ASNumber
-                if(contains(isec_adopted_as_list, get<ASNumber>(as_number))){
-                    adopted_path_as.push_back(get<ASNumber>(as_number));
+            // Each adopting AS on the path must be in the ProConID of the previous adopting AS.
+            int last_adopted = -1;
+            for(const auto& as_number : path){
+                const int id = registry.get_id(as_number_on_path(as_number));
+                if(!registry.is_isec_adopted(id)){
+                    continue;
                 }
-            }
-            int i = 0;
-            while(i < static_cast<int>(size(adopted_path_as)) - 1){
-                if(!contains(public_ProConID[adopted_path_as[i]], adopted_path_as[i+1])){
+                if(last_adopted >= 0 && !registry.is_ProConID(last_adopted, id)){
                     return Isec::Invalid;
                 }
-                ++i;
+                last_adopted = id;
             }
-            if(update_msg.come_from == ComeFrom::Peer){
+            if(come_from == ComeFrom::Peer){
                 return Isec::Valid;
-            }else if(update_msg.come_from == ComeFrom::Customer){
-                if(contains(public_ProConID[adopted_path_as.back()], *update_msg.dst)){
+            }else if(come_from == ComeFrom::Customer){
+                if(registry.is_ProConID(last_adopted, receiver)){
                     return Isec::Valid;
                 }else{
                     return Isec::Invalid;
@@ -152,103 +392,109 @@ public:
         throw logic_error("\n\033[31m[ERROR] Unreachable code reached in function: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
     }
 
-    void new_route_security_validation(Route* route, Message update_msg){
-        route->aspv = aspv(*route, update_msg.src);
-        route->isec_v = isec_v(*route, update_msg);
+    void new_route_security_validation(PackedRoute& route, const Message& update_msg) const {
+        route.set_aspv(aspv(*update_msg.path, *update_msg.come_from, update_msg.src));
+        route.set_isec_v(isec_v(update_msg));
         // other security function should be added here.
     }
 
-    optional<RouteDiff> update(Message update_msg){
-        IPAddress network  = *update_msg.address;
-        Path path          = *update_msg.path;
-        ComeFrom come_from = *update_msg.come_from;
-        int LocPrf;
+    bool is_preferred(const PackedRoute& new_route, const PackedRoute& best) const {
+        return is_preferred(policy, new_route, best);
+    }
+
+    static bool is_preferred(const vector<Policy>& policy, const PackedRoute& new_route, const PackedRoute& best){
+        // Whether the new route replaces the current best route, following the policy in order.
+        for(const Policy& p : policy){
+            switch(p) {
+                case Policy::LocPrf:
+                    if(new_route.get_LocPrf() > best.get_LocPrf()){
+                        return true;
+                    }else if(new_route.get_LocPrf() < best.get_LocPrf()){
+                        return false;
+                    }
+                    break;
+                case Policy::PathLength:
+                    if(new_route.path_length < best.path_length){
+                        return true;
+                    }else if(new_route.path_length > best.path_length){
+                        return false;
+                    }
+                    break;
+                case Policy::Aspa:
+                    if(new_route.get_aspv() == ASPV::Invalid){
+                        return false;
+                    }
+                    break;
+                case Policy::Isec:
+                    if(new_route.get_isec_v() == Isec::Invalid){
+                        return false;
+                    }
+                    break;
+                default:
+                    throw logic_error("\n\033[31m[ERROR] Invalid Policy type: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+                    break;
+            }
+        }
+        return false;
+    }
+
+    optional<RouteDiff> update(const Message& update_msg){
+        const IPAddress& network = *update_msg.address;
+        const Path& path         = *update_msg.path;
+        ComeFrom come_from       = *update_msg.come_from;
+        PackedRoute new_route = {};
+        new_route.come_from = static_cast<int>(come_from);
         switch(come_from){
-            case ComeFrom::Customer: LocPrf = 200; break;
-            case ComeFrom::Peer:     LocPrf = 100; break;
-            case ComeFrom::Provider: LocPrf = 50;  break;
+            case ComeFrom::Customer: new_route.LocPrf = static_cast<int>(LocPrfClass::Customer); break;
+            case ComeFrom::Peer:     new_route.LocPrf = static_cast<int>(LocPrfClass::Peer);     break;
+            case ComeFrom::Provider: new_route.LocPrf = static_cast<int>(LocPrfClass::Provider); break;
         }
-        Route* new_route = new Route{path, come_from, LocPrf, false, nullopt, nullopt};
+        new_route.path_length = path.size();
 
         new_route_security_validation(new_route, update_msg);
 
-        if(table.count(network) > 0){ /* when the network already has several routes. */
-            table[network].push_back(new_route);
-
-            Route* best = nullptr;
-            for(Route* r : table[network]){
-                if(r->best_path){
-                    best = r;
-                    break;
-                }
-            }
-            if(best == nullptr){
+        const RouteBlock* found_block = find_block(network);
+        if(found_block != nullptr){ /* when the network already has several routes. */
+            int best = found_block->get_best_index();
+            bool replace_best = false;
+            if(best < 0){
                 /* raise BestPathNotExist */
-                if(policy.front() == Policy::Aspa && new_route->aspv == ASPV::Invalid){
-                    new_route->best_path = false;
-                    return nullopt;
-                }else{
-                    new_route->best_path = true;
-                    return RouteDiff{come_from, path, network};
-                }
-            }else{
-                int new_length, best_length;
-                for(const Policy& p : policy){
-                    switch(p) {
-                        case Policy::LocPrf:
-                            if(new_route->LocPrf > best->LocPrf){
-                                new_route->best_path = true;
-                                best->best_path = false;
-                                return RouteDiff{new_route->come_from, new_route->path, network};
-                            }else if(new_route->LocPrf == best->LocPrf){
-                                continue;
-                            }else if(new_route->LocPrf < best->LocPrf){
-                                return nullopt;
-                            }
-                            break;
-                        case Policy::PathLength:
-                            new_length = new_route->path.size();
-                            best_length = best->path.size();
-                            if(new_length < best_length){
-                                new_route->best_path = true;
-                                best->best_path = false;
-                                return RouteDiff{new_route->come_from, new_route->path, network};
-                            }else if(new_length == best_length){
-                                continue;
-                            }else if(new_length > best_length){
-                                return nullopt;
-                            }
-                            break;
-                        case Policy::Aspa:
-                            if(new_route->aspv == ASPV::Invalid){
-                                return nullopt;
-                            }
-                            break;
-                        case Policy::Isec:
-                            if(new_route->isec_v == Isec::Invalid){
-                                return nullopt;
-                            }
-                            break;
-                        default:
-                            throw logic_error("\n\033[31m[ERROR] Invalid Policy type: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
-                            break;
-                    }
-                }
+                new_route.best_path = !(policy.front() == Policy::Aspa && new_route.get_aspv() == ASPV::Invalid);
+            }else if(is_preferred(new_route, found_block->route_list[best])){
+                new_route.best_path = true;
+                replace_best = true;
+            }
+            if(rib_mode == RibMode::BestOnly && !new_route.best_path){
+                return nullopt;
             }
+            // The block is copied from base_table only here, when it is actually changed.
+            RouteBlock& block = get_block(network);
+            if(replace_best){
+                block.route_list[best].best_path = false;
+            }
+            if(rib_mode == RibMode::BestOnly){
+                block.route_list.clear();
+                block.path_list.clear();
+            }
+            block.add_route(new_route, path);
         }else{ /* when the network DOES NOT HAVE any routes. */
             // SECURITY CHECK;
-            if(contains(policy, Policy::Aspa) && new_route->aspv == ASPV::Invalid){
-                new_route->best_path = false;
-                table[network].push_back(new_route);
-                return nullopt;
+            new_route.best_path = true;
+            if(contains(policy, Policy::Aspa) && new_route.get_aspv() == ASPV::Invalid){
+                new_route.best_path = false;
             }
-            if(contains(policy, Policy::Isec) && new_route->isec_v == Isec::Invalid){
-                new_route->best_path = false;
-                table[network].push_back(new_route);
-                return nullopt;
+            if(contains(policy, Policy::Isec) && new_route.get_isec_v() == Isec::Invalid){
+                new_route.best_path = false;
             }
-            new_route->best_path = true;
-            table[network].push_back(new_route);
+            length_set |= uint64_t{1} << network.length;
+            if(rib_mode == RibMode::BestOnly && !new_route.best_path){
+                table[network] = RouteBlock{};
+            }else{
+                table[network].add_route(new_route, path);
+            }
+        }
+        change_num++;
+        if(new_route.best_path){
             return RouteDiff{come_from, path, network};
         }
         return nullopt;
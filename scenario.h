@@ -0,0 +1,989 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+/***
+ *** Attack scenarios, and the Monte Carlo sweep of the adoption rate of ASPA or BGP-iSec.
+ *** A scenario is the same as the following steps on the given instance, with all routing tables empty:
+ ***   1. the adopting AS publish their ASPA (or BGP-iSec adoption) and enable the verification,
+ ***   2. add_all_init() and run(),
+ ***   3. the attacker advertises the forged route, which is propagated by run().
+ *** The hijack rate is the fraction of AS (except the attacker and the victim) whose best path
+ *** to the attacked network traverses the attacker.
+ *** Only the routes to the network of the victim are propagated at step 2 (the networks are independent, see LOTUS::run_sharded()).
+ ***/
+
+struct Scenario{
+    ASNumber attacker;
+    ASNumber victim;
+    vector<ASNumber> adopter_list;
+};
+
+struct ScenarioResult{
+    size_t affected_num = 0;  // AS whose best path traverses the attacker
+    size_t total_num = 0;     // AS except the attacker and the victim
+
+    double hijack_rate(void) const {
+        return total_num == 0 ? 0.0 : static_cast<double>(affected_num) / total_num;
+    }
+};
+
+class RunningEstimate{
+    // Mean and variance updated one sample at a time (Welford's method).
+public:
+    size_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+public:
+    void add(double x){
+        count += 1;
+        const double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+
+    double variance(void) const {
+        return count < 2 ? 0.0 : m2 / (count - 1);
+    }
+
+    double stddev(void) const {
+        return sqrt(variance());
+    }
+
+    double half_width(double z) const {
+        // Half width of the confidence interval of the mean (normal approximation).
+        return count == 0 ? 0.0 : z * stddev() / sqrt(static_cast<double>(count));
+    }
+
+    static double z_value(double confidence){
+        // z such that P(|Z| <= z) = confidence for the standard normal distribution.
+        if(confidence <= 0.0 || 1.0 <= confidence){
+            throw logic_error("\n\033[31m[ERROR] The confidence " + to_string(confidence) + " is out of range (0, 1): " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        double low = 0.0, high = 40.0;
+        for(int i = 0; i < 100; ++i){
+            const double z = (low + high) / 2;
+            if(erfc(z / sqrt(2.0)) > 1.0 - confidence){
+                low = z;
+            }else{
+                high = z;
+            }
+        }
+        return (low + high) / 2;
+    }
+};
+
+class ScenarioRunner{
+    // The instance without any route is copied for each scenario.
+    // run() only reads it, and can be called by several threads with their own instances.
+public:
+    LOTUS base;
+    vector<ASNumber> as_list;  // registered AS, in ascending order
+    Policy mechanism;
+    AttackType attack_type;
+    int priority;
+
+public:
+    ScenarioRunner(LOTUS& lotus, Policy mechanism=Policy::Aspa, AttackType attack_type=AttackType::ForgedOrigin, int priority=1){
+        if(mechanism != Policy::Aspa && mechanism != Policy::Isec){
+            throw logic_error("\n\033[31m[ERROR] The mechanism MUST be Policy::Aspa or Policy::Isec: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        this->mechanism = mechanism;
+        this->attack_type = attack_type;
+        this->priority = priority;
+        base = lotus.fork();
+        base.set_transit_index(false);
+        base.clear_messages();
+        base.clear_routing_tables();
+        base.get_as_graph();
+        for(auto it = base.as_class_list.class_list.begin(); it != base.as_class_list.class_list.end(); it++){
+            as_list.push_back(it->first);
+        }
+    }
+
+    ScenarioResult run(const Scenario& scenario, LOTUS& instance) const {
+        // <instance> is overwritten by a copy of the instance without any route (it can be reused by the caller).
+        instance = base;
+        if(mechanism == Policy::Aspa){
+            instance.auto_ASPA_list(scenario.adopter_list);
+            for(const ASNumber as_number : scenario.adopter_list){
+                instance.set_ASPV(as_number, true, priority);
+            }
+        }else /* mechanism == Policy::Isec */{
+            for(const ASNumber as_number : scenario.adopter_list){
+                instance.switch_adoption_iSec(as_number, true, priority);
+            }
+            instance.add_ProConID_all();
+        }
+
+        // Only the neighbors of the victim receive a route by their Init messages.
+        IPAddress network = instance.get_AS(scenario.victim)->network_address;
+        instance.get_AS(scenario.victim)->routing_table.add_origin(network);
+        vector<ASNumber> neighbor_list;
+        for(const Connection& c : instance.get_connection_with(scenario.victim)){
+            neighbor_list.push_back(c.src == scenario.victim ? c.dst : c.src);
+        }
+        sort(neighbor_list.begin(), neighbor_list.end());
+        neighbor_list.erase(unique(neighbor_list.begin(), neighbor_list.end()), neighbor_list.end());
+        for(const ASNumber neighbor : neighbor_list){
+            instance.add_messages(MessageType::Init, neighbor);
+        }
+        instance.run();
+
+        if(attack_type == AttackType::ForgedOrigin){
+            instance.gen_attack(scenario.attacker, scenario.victim);
+        }else /* attack_type == AttackType::SubPrefix */{
+            if(network.length == 32){
+                std::cout << "\033[33m[WARN] The network " << network << " of AS " << scenario.victim << " has no sub-prefix, no attack has been generated.\033[00m" << std::endl;
+                return ScenarioResult{0, as_list.size() - 2};
+            }
+            instance.gen_subprefix_attack(scenario.attacker, scenario.victim, network.length + 1);
+            network = IPv4Prefix{network.address, network.length + 1};
+        }
+        instance.run();
+
+        ScenarioResult result;
+        Path path;
+        for(auto it = instance.as_class_list.class_list.begin(); it != instance.as_class_list.class_list.end(); it++){
+            if(it->first == scenario.attacker || it->first == scenario.victim){
+                continue;
+            }
+            result.total_num += 1;
+            if(it->second.routing_table.get_best_path(network, path) && contains(path, scenario.attacker)){
+                result.affected_num += 1;
+            }
+        }
+        return result;
+    }
+
+    vector<ASNumber> choose_adopter_list(double adoption_rate, mt19937_64& rng) const {
+        // round(rate * the number of AS) AS chosen at random, in ascending order.
+        vector<ASNumber> adopter_list = as_list;
+        const size_t chosen_num = static_cast<size_t>(llround(min(max(adoption_rate, 0.0), 1.0) * adopter_list.size()));
+        for(size_t i = 0; i < chosen_num; ++i){
+            uniform_int_distribution<size_t> dist(i, adopter_list.size() - 1);
+            swap(adopter_list[i], adopter_list[dist(rng)]);
+        }
+        adopter_list.resize(chosen_num);
+        sort(adopter_list.begin(), adopter_list.end());
+        return adopter_list;
+    }
+
+    vector<ASNumber> registered_only(const vector<ASNumber>& candidate_list) const {
+        // The registered AS on the list, or all AS if the list is empty.
+        if(candidate_list.empty()){
+            return as_list;
+        }
+        vector<ASNumber> registered_list;
+        for(const ASNumber as_number : candidate_list){
+            if(binary_search(as_list.begin(), as_list.end(), as_number)){
+                registered_list.push_back(as_number);
+            }else{
+                std::cout << "\033[33m[WARN] Since AS " << as_number << " has NOT been registered, it is NOT chosen.\033[00m" << std::endl;
+            }
+        }
+        return registered_list;
+    }
+};
+
+struct ASNumberSpan{
+    // A path on the path pool of LaneScenarioRunner (internal order, origin first).
+    const ASNumber* first;
+    size_t length;
+
+    const ASNumber* begin(void) const { return first; }
+    const ASNumber* end(void) const { return first + length; }
+    size_t size(void) const { return length; }
+    ASNumber operator[](size_t i) const { return first[i]; }
+};
+
+class LaneScenarioRunner{
+    // Up to 64 scenarios with the same attacker and victim, and different adopting AS, in one pass.
+    // Lane l of each mask is the scenario l. A message is queued once for all the lanes which send it,
+    // and the routes are kept per AS as groups of lanes sharing the same best route.
+    // A group is split only when the lanes decide differently on a message (the adoption differs),
+    // thus the lanes in the same state share one route selection per policy (with / without the mechanism).
+    // The messages of each lane are processed in the same order as ScenarioRunner::run(), thus the results are the same.
+public:
+    static constexpr int LANE_NUM = 64;
+    static constexpr int NO_BEST = -1;  // the lanes received a route, but have no best route
+
+    struct LaneMessage{
+        int src;
+        int dst;
+        uint32_t path_offset;
+        uint16_t path_length;
+        uint64_t lane_mask;
+    };
+
+    struct LaneGroup{
+        uint64_t lane_mask;
+        int route;  // index on the route list, or NO_BEST
+    };
+
+    struct LaneNeighbor{
+        int id;
+        ComeFrom come_from;  // the class of the routes received from the neighbor
+        bool is_customer;
+    };
+
+    const ScenarioRunner& runner;
+    shared_ptr<const ASGraph> as_graph;
+    shared_ptr<const SecurityRegistry> base_registry;
+    vector<array<vector<Policy>, 2>> policy_list;  // dense id -> {policy without the mechanism, with it}
+    vector<char> registered;                       // dense id -> whether the AS is registered
+    Adjacency neighbor_index;                      // dense id -> indexes on neighbor_list (in the order of get_connection_with())
+    vector<LaneNeighbor> neighbor_list;
+
+private:
+    struct LaneState{
+        uint64_t lane_all;
+        vector<uint64_t> adopted;                          // dense id -> lanes where the AS adopts the mechanism
+        unordered_map<int, vector<pair<int, uint64_t>>> ProConID_cache;  // dense id -> sorted {dense id, lanes where it is in the ProConID} (BGP-iSec only)
+        vector<uint64_t> reachable;                        // dense id -> lanes, work area of ProConID_lanes()
+        vector<vector<LaneGroup>> group_list;              // dense id -> groups of the lanes
+        vector<PackedRoute> route_list;                    // path_offset is on path_pool
+        vector<ASNumber> path_pool;
+        queue<LaneMessage> message_queue;
+    };
+
+public:
+    LaneScenarioRunner(const ScenarioRunner& runner) : runner(runner){
+        LOTUS instance = runner.base;
+        base_registry = instance.get_security_registry();
+        as_graph = base_registry->as_graph;
+        const int n = static_cast<int>(as_graph->size());
+        policy_list.resize(n);
+        registered.assign(n, 0);
+        neighbor_index.offset.assign(n + 1, 0);
+        for(int id = 0; id < n; ++id){
+            const ASNumber as_number = as_graph->as_number_list[id];
+            if(const ASClass* as_class = instance.get_AS(as_number)){
+                registered[id] = 1;
+                policy_list[id][0] = as_class->policy;
+                policy_list[id][1] = as_class->policy;
+                // The same as set_ASPV() and switch_adoption_iSec() (which ignores the AS already adopting).
+                if(runner.mechanism == Policy::Aspa || !base_registry->is_isec_adopted(id)){
+                    policy_list[id][1].insert(policy_list[id][1].begin() + (runner.priority - 1), runner.mechanism);
+                }
+            }
+            for(const Connection& c : instance.get_connection_with(as_number)){
+                const ASNumber neighbor = (c.src == as_number) ? c.dst : c.src;
+                ComeFrom come_from = ComeFrom::Peer;
+                if(c.type == ConnectionType::Down){
+                    come_from = (neighbor == c.src) ? ComeFrom::Provider : ComeFrom::Customer;
+                }
+                neighbor_index.target.push_back(static_cast<int>(neighbor_list.size()));
+                neighbor_list.push_back(LaneNeighbor{as_graph->get_id(neighbor), come_from, c.type == ConnectionType::Down && c.src == as_number});
+            }
+            neighbor_index.offset[id + 1] = static_cast<int>(neighbor_index.target.size());
+        }
+    }
+
+    vector<ScenarioResult> run(ASNumber attacker, ASNumber victim, const vector<vector<ASNumber>>& adopter_list_list) const {
+        // The same results as ScenarioRunner::run() for the scenarios {attacker, victim, adopter_list_list[l]}.
+        const size_t lane_num = adopter_list_list.size();
+        if(LANE_NUM < lane_num){
+            throw logic_error("\n\033[31m[ERROR] At most " + to_string(LANE_NUM) + " scenarios can be run at once, but " + to_string(lane_num) + " are given: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        const int attacker_id = as_graph->get_id(attacker);
+        const int victim_id = as_graph->get_id(victim);
+        if(attacker_id < 0 || !registered[attacker_id] || victim_id < 0 || !registered[victim_id]){
+            throw logic_error("\n\033[31m[ERROR] The attacker and the victim MUST be registered: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        vector<ScenarioResult> result(lane_num);
+        if(lane_num == 0){
+            return result;
+        }
+
+        LaneState state;
+        state.lane_all = (lane_num == LANE_NUM) ? ~uint64_t{0} : (uint64_t{1} << lane_num) - 1;
+        state.adopted.assign(as_graph->size(), 0);
+        for(size_t lane = 0; lane < lane_num; ++lane){
+            for(const ASNumber as_number : adopter_list_list[lane]){
+                const int id = as_graph->get_id(as_number);
+                if(id >= 0){
+                    state.adopted[id] |= uint64_t{1} << lane;
+                }
+            }
+        }
+        if(runner.mechanism == Policy::Isec){
+            state.reachable.assign(as_graph->size(), 0);
+        }
+        state.group_list.resize(as_graph->size());
+
+        if(runner.attack_type == AttackType::ForgedOrigin){
+            // The Init messages of the neighbors of the victim (see ScenarioRunner::run()).
+            vector<int> init_list;
+            for(const int index : neighbor_index.of(victim_id)){
+                init_list.push_back(neighbor_list[index].id);
+            }
+            sort(init_list.begin(), init_list.end());
+            init_list.erase(unique(init_list.begin(), init_list.end()), init_list.end());
+            const uint32_t origin_path = add_path(state, {victim});
+            for(const int neighbor : init_list){
+                for(const int index : neighbor_index.of(neighbor)){
+                    if(neighbor_list[index].id == victim_id){
+                        state.message_queue.push(LaneMessage{victim_id, neighbor, origin_path, 1, state.lane_all});
+                    }
+                }
+            }
+            process_all(state);
+        }else /* attack_type == AttackType::SubPrefix */{
+            // The routes to the sub-prefix do not depend on the routes to the network of the victim.
+            if(runner.base.as_class_list.class_list.at(victim).network_address.length == 32){
+                std::cout << "\033[33m[WARN] The network of AS " << victim << " has no sub-prefix, no attack has been generated.\033[00m" << std::endl;
+                for(ScenarioResult& r : result){
+                    r = ScenarioResult{0, runner.as_list.size() - 2};
+                }
+                return result;
+            }
+        }
+        const uint32_t attack_path = add_path(state, {victim, attacker});
+        for(const int index : neighbor_index.of(attacker_id)){
+            state.message_queue.push(LaneMessage{attacker_id, neighbor_list[index].id, attack_path, 2, state.lane_all});
+        }
+        process_all(state);
+
+        for(const ASNumber as_number : runner.as_list){
+            if(as_number == attacker || as_number == victim){
+                continue;
+            }
+            for(ScenarioResult& r : result){
+                r.total_num += 1;
+            }
+            for(const LaneGroup& g : state.group_list[as_graph->get_id(as_number)]){
+                if(g.route == NO_BEST){
+                    continue;
+                }
+                const PackedRoute& route = state.route_list[g.route];
+                const auto path_begin = state.path_pool.begin() + route.path_offset;
+                if(find(path_begin, path_begin + route.path_length, attacker) != path_begin + route.path_length){
+                    for(uint64_t lanes = g.lane_mask; lanes != 0; lanes &= lanes - 1){
+                        result[__builtin_ctzll(lanes)].affected_num += 1;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+private:
+    static uint32_t add_path(LaneState& state, const vector<ASNumber>& path){
+        const uint32_t offset = state.path_pool.size();
+        state.path_pool.insert(state.path_pool.end(), path.begin(), path.end());
+        return offset;
+    }
+
+    void process_all(LaneState& state) const {
+        while(!state.message_queue.empty()){
+            const LaneMessage msg = state.message_queue.front();
+            state.message_queue.pop();
+            update(msg, state);
+        }
+    }
+
+    uint64_t lanes_with(const vector<Policy>& without, const vector<Policy>& with, uint64_t adopted, uint64_t lane_mask, bool (*has)(const vector<Policy>&)) const {
+        // The lanes whose policy satisfies <has>.
+        return ((has(without) ? ~adopted : 0) | (has(with) ? adopted : 0)) & lane_mask;
+    }
+
+    uint64_t aspa_invalid_lanes(const ASNumberSpan& path, ComeFrom come_from, ASNumber neighbor_as, uint64_t lane_mask, const LaneState& state) const {
+        // The lanes where ASPV of the route is Invalid (the same steps as RoutingTable::aspv() on the masks).
+        if(path[path.size() - 1] != neighbor_as){
+            return lane_mask;
+        }
+        auto pair_invalid = [&](ASNumber customer, ASNumber provider){
+            uint64_t invalid = (base_registry->verify_pair(customer, provider) == ASPV::Invalid) ? lane_mask : 0;
+            if(runner.mechanism == Policy::Aspa){
+                // The adopting AS publish all of their providers (see LOTUS::auto_ASPA_list()).
+                const int id = as_graph->get_id(customer);
+                const uint64_t published = (id >= 0) ? state.adopted[id] & lane_mask : 0;
+                const int provider_id = as_graph->get_id(provider);
+                bool is_provider = false;
+                if(id >= 0){
+                    for(const int p : as_graph->providers.of(id)){
+                        is_provider |= (p == provider_id);
+                    }
+                }
+                invalid = (invalid & ~published) | (is_provider ? 0 : published);
+            }
+            return invalid;
+        };
+
+        uint64_t invalid = 0;
+        if(come_from == ComeFrom::Customer || come_from == ComeFrom::Peer){
+            for(size_t i = 0; i + 1 < path.size() && invalid != lane_mask; ++i){
+                invalid |= pair_invalid(path[i], path[i+1]);
+            }
+        }else /* come_from == ComeFrom::Provider */{
+            // The lanes leave the upflow fragment at the first Invalid pair, and then check the pairs downward.
+            uint64_t upflow = lane_mask;
+            for(size_t i = 0; i < path.size() && invalid != lane_mask; ++i){
+                const uint64_t downflow = lane_mask & ~upflow & ~invalid;
+                if(downflow != 0){
+                    invalid |= downflow & pair_invalid(path[i], path[i-1]);
+                }
+                if(upflow != 0 && i + 1 < path.size()){
+                    upflow &= ~pair_invalid(path[i], path[i+1]);
+                }
+            }
+        }
+        return invalid;
+    }
+
+    uint64_t isec_adopted_lanes(int id, const LaneState& state) const {
+        // The lanes where the AS publishes its adoption of BGP-iSec (the same as switch_adoption_iSec() on the base).
+        if(id < 0){
+            return 0;
+        }
+        return base_registry->is_isec_adopted(id) ? state.lane_all : state.adopted[id];
+    }
+
+    uint64_t ProConID_lanes(int customer, int provider, LaneState& state) const {
+        // The lanes where <provider> is in the ProConID of <customer> (the same as LOTUS::add_ProConID_all() on each lane).
+        // The providers reachable from <customer> through the NON adopting AS are searched once for all the lanes,
+        // and cached for the other checks of the scenario.
+        auto it = state.ProConID_cache.find(customer);
+        if(it == state.ProConID_cache.end()){
+            vector<int> visited;
+            vector<int> stack;
+            auto reach = [&](int id, uint64_t lanes){
+                if((lanes & ~state.reachable[id]) == 0){
+                    return;
+                }
+                if(state.reachable[id] == 0){
+                    visited.push_back(id);
+                }
+                state.reachable[id] |= lanes;
+                stack.push_back(id);
+            };
+            for(const int p : as_graph->providers.of(customer)){
+                reach(p, state.lane_all);
+            }
+            while(!stack.empty()){
+                const int id = stack.back();
+                stack.pop_back();
+                const uint64_t through = state.reachable[id] & ~isec_adopted_lanes(id, state);
+                if(through != 0){
+                    for(const int p : as_graph->providers.of(id)){
+                        reach(p, through);
+                    }
+                }
+            }
+            vector<pair<int, uint64_t>> ProConID;
+            const uint64_t customer_lanes = isec_adopted_lanes(customer, state);
+            for(const int id : visited){
+                const uint64_t lanes = state.reachable[id] & customer_lanes & isec_adopted_lanes(id, state);
+                if(lanes != 0 && id != customer){
+                    ProConID.emplace_back(id, lanes);
+                }
+                state.reachable[id] = 0;
+            }
+            sort(ProConID.begin(), ProConID.end());
+            it = state.ProConID_cache.emplace(customer, move(ProConID)).first;
+        }
+        const vector<pair<int, uint64_t>>& ProConID = it->second;
+        auto found = lower_bound(ProConID.begin(), ProConID.end(), pair<int, uint64_t>{provider, 0});
+        return (found != ProConID.end() && found->first == provider) ? found->second : 0;
+    }
+
+    uint64_t isec_invalid_lanes(const ASNumberSpan& path, ComeFrom come_from, ASNumber receiver_as, uint64_t lane_mask, LaneState& state) const {
+        if(runner.mechanism != Policy::Isec){
+            return (RoutingTable::isec_v(*base_registry, receiver_as, path, come_from) == Isec::Invalid) ? lane_mask : 0;
+        }
+        // The same steps as RoutingTable::isec_v() on the masks, where the adopting AS differ between the lanes.
+        const int receiver = as_graph->get_id(receiver_as);
+        const uint64_t evaluated = lane_mask & isec_adopted_lanes(receiver, state) & isec_adopted_lanes(as_graph->get_id(path[0]), state);
+        if(evaluated == 0 || come_from == ComeFrom::Provider){
+            return 0;
+        }
+        // The last adopting AS on the path, and the lanes where it is the last one.
+        vector<pair<int, uint64_t>> last_adopted;
+        uint64_t invalid = 0;
+        for(const ASNumber as_number : path){
+            const int id = as_graph->get_id(as_number);
+            const uint64_t adopted = evaluated & isec_adopted_lanes(id, state);
+            if(adopted == 0){
+                continue;
+            }
+            for(pair<int, uint64_t>& last : last_adopted){
+                const uint64_t lanes = last.second & adopted;
+                if(lanes != 0){
+                    invalid |= lanes & ~ProConID_lanes(last.first, id, state);
+                    last.second &= ~adopted;
+                }
+            }
+            last_adopted.emplace_back(id, adopted);
+        }
+        if(come_from == ComeFrom::Customer){
+            for(const pair<int, uint64_t>& last : last_adopted){
+                if(last.second != 0){
+                    invalid |= last.second & ~ProConID_lanes(last.first, receiver, state);
+                }
+            }
+        }
+        return invalid;
+    }
+
+    void update(const LaneMessage& msg, LaneState& state) const {
+        // ASClass::update() and RoutingTable::update() of the AS <msg.dst> for the lanes of the message.
+        const ASNumber dst_as = as_graph->as_number_list[msg.dst];
+        const ASNumberSpan path{state.path_pool.data() + msg.path_offset, msg.path_length};
+        if(!registered[msg.dst] || find(path.begin(), path.end(), dst_as) != path.end()){
+            return;
+        }
+        const LaneNeighbor* sender = nullptr;
+        for(const int index : neighbor_index.of(msg.dst)){
+            if(neighbor_list[index].id == msg.src){
+                sender = &neighbor_list[index];
+                break;
+            }
+        }
+        if(sender == nullptr){
+            return;
+        }
+        const ComeFrom come_from = sender->come_from;
+        PackedRoute new_route = {};
+        new_route.come_from = static_cast<int>(come_from);
+        switch(come_from){
+            case ComeFrom::Customer: new_route.LocPrf = static_cast<int>(LocPrfClass::Customer); break;
+            case ComeFrom::Peer:     new_route.LocPrf = static_cast<int>(LocPrfClass::Peer);     break;
+            case ComeFrom::Provider: new_route.LocPrf = static_cast<int>(LocPrfClass::Provider); break;
+        }
+        new_route.path_offset = msg.path_offset;
+        new_route.path_length = msg.path_length;
+
+        // The security checks are evaluated only on the lanes whose policy refers to them.
+        const array<vector<Policy>, 2>& policy = policy_list[msg.dst];
+        const uint64_t adopted = state.adopted[msg.dst];
+        auto has_aspa = [](const vector<Policy>& p){ return contains(p, Policy::Aspa); };
+        auto has_isec = [](const vector<Policy>& p){ return contains(p, Policy::Isec); };
+        auto front_aspa = [](const vector<Policy>& p){ return !p.empty() && p.front() == Policy::Aspa; };
+        const uint64_t aspa_lanes = lanes_with(policy[0], policy[1], adopted, msg.lane_mask, has_aspa);
+        const uint64_t isec_lanes = lanes_with(policy[0], policy[1], adopted, msg.lane_mask, has_isec);
+        const uint64_t aspa_invalid = (aspa_lanes != 0) ? aspa_invalid_lanes(path, come_from, as_graph->as_number_list[msg.src], aspa_lanes, state) : 0;
+        const uint64_t isec_invalid = (isec_lanes != 0) ? isec_invalid_lanes(path, come_from, dst_as, isec_lanes, state) : 0;
+
+        vector<LaneGroup>& group_list = state.group_list[msg.dst];
+        uint64_t covered = 0;
+        uint64_t accepted = 0;
+        for(const LaneGroup& g : group_list){
+            covered |= g.lane_mask;
+            const uint64_t lanes = g.lane_mask & msg.lane_mask;
+            if(lanes == 0){
+                continue;
+            }
+            if(g.route == NO_BEST){
+                accepted |= lanes & ~(lanes_with(policy[0], policy[1], adopted, lanes, front_aspa) & aspa_invalid);
+                continue;
+            }
+            // One route selection for each combination of the policy and the results of the checks.
+            const PackedRoute& best = state.route_list[g.route];
+            for(int with = 0; with < 2; ++with){
+                for(int aspa = 0; aspa < 2; ++aspa){
+                    for(int isec = 0; isec < 2; ++isec){
+                        const uint64_t combination = lanes & (with ? adopted : ~adopted) & (aspa ? aspa_invalid : ~aspa_invalid) & (isec ? isec_invalid : ~isec_invalid);
+                        if(combination == 0){
+                            continue;
+                        }
+                        PackedRoute r = new_route;
+                        r.set_aspv(aspa ? ASPV::Invalid : ASPV::Valid);
+                        r.set_isec_v(isec ? optional<Isec>(Isec::Invalid) : nullopt);
+                        if(RoutingTable::is_preferred(policy[with], r, best)){
+                            accepted |= combination;
+                        }
+                    }
+                }
+            }
+        }
+        // The lanes without any route to the network.
+        const uint64_t fresh = msg.lane_mask & ~covered;
+        const uint64_t rejected = fresh & (aspa_invalid | isec_invalid);
+        accepted |= fresh & ~rejected;
+        if(rejected != 0){
+            auto it = find_if(group_list.begin(), group_list.end(), [](const LaneGroup& g){ return g.route == NO_BEST; });
+            if(it == group_list.end()){
+                group_list.push_back(LaneGroup{rejected, NO_BEST});
+            }else{
+                it->lane_mask |= rejected;
+            }
+        }
+        if(accepted == 0){
+            return;
+        }
+        for(LaneGroup& g : group_list){
+            g.lane_mask &= ~accepted;
+        }
+        group_list.erase(remove_if(group_list.begin(), group_list.end(), [](const LaneGroup& g){ return g.lane_mask == 0; }), group_list.end());
+        group_list.push_back(LaneGroup{accepted, static_cast<int>(state.route_list.size())});
+        state.route_list.push_back(new_route);
+
+        // The same messages as LOTUS::run(), sent once for all the accepting lanes.
+        uint32_t new_path = 0;
+        bool path_added = false;
+        for(const int index : neighbor_index.of(msg.dst)){
+            const LaneNeighbor& neighbor = neighbor_list[index];
+            if(come_from != ComeFrom::Customer && !neighbor.is_customer){
+                continue;
+            }
+            if(!path_added){
+                new_path = state.path_pool.size();
+                for(uint16_t i = 0; i < msg.path_length; ++i){
+                    const ASNumber as_on_path = state.path_pool[msg.path_offset + i];
+                    state.path_pool.push_back(as_on_path);
+                }
+                state.path_pool.push_back(dst_as);
+                path_added = true;
+            }
+            state.message_queue.push(LaneMessage{msg.dst, neighbor.id, new_path, static_cast<uint16_t>(msg.path_length + 1), accepted});
+        }
+    }
+};
+
+struct SweepSetting{
+    Policy mechanism = Policy::Aspa;                      // Policy::Aspa or Policy::Isec
+    AttackType attack_type = AttackType::ForgedOrigin;
+    vector<double> adoption_rate_list = {0.0, 0.25, 0.5, 0.75, 1.0};
+    int trial_num = 100;                                  // trials for each adoption rate
+    unsigned int seed = 0;
+    int priority = 1;                                     // priority of the mechanism in the policy of the adopting AS
+    double confidence = 0.95;
+    vector<ASNumber> attacker_list = {};                  // candidates of the attacker (all AS if empty)
+    vector<ASNumber> victim_list = {};                    // candidates of the victim (all AS if empty)
+    bool bitsliced = true;                                // the adoption rates of a trial are run in the lanes of LaneScenarioRunner
+};
+
+struct SweepPoint{
+    double adoption_rate;
+    size_t trial_num;
+    double mean;          // mean hijack rate
+    double stddev;
+    double ci_low;
+    double ci_high;
+    double success_rate;  // fraction of the trials where at least one AS is hijacked
+};
+
+class AdoptionSweep{
+    // Trials are distributed over the threads (OpenMP), each of which reuses its own instance.
+    // The attacker and the victim of a trial only depend on the seed and the trial number (the same for all
+    // adoption rates), and the adopting AS on the adoption rate in addition, thus the result depends neither on
+    // the number of threads nor on setting.bitsliced.
+public:
+    SweepSetting setting;
+    vector<SweepPoint> result;
+
+public:
+    AdoptionSweep(SweepSetting setting){
+        this->setting = setting;
+    }
+
+    const vector<SweepPoint>& run(LOTUS& lotus){
+        result.clear();
+        const double z = RunningEstimate::z_value(setting.confidence);
+        const ScenarioRunner runner(lotus, setting.mechanism, setting.attack_type, setting.priority);
+        const vector<ASNumber> victim_list = runner.registered_only(setting.victim_list);
+        // An attacker is drawn only if there is a victim other than itself.
+        vector<ASNumber> attacker_list;
+        for(const ASNumber attacker : runner.registered_only(setting.attacker_list)){
+            if(any_of(victim_list.begin(), victim_list.end(), [&](ASNumber victim){ return victim != attacker; })){
+                attacker_list.push_back(attacker);
+            }
+        }
+        if(attacker_list.empty()){
+            std::cout << "\033[33m[WARN] There is no pair of a different attacker and victim, no trial has been run.\033[00m" << std::endl;
+            return result;
+        }
+        if(setting.trial_num <= 0){
+            return result;
+        }
+
+        const size_t rate_num = setting.adoption_rate_list.size();
+        const size_t trial_num = setting.trial_num;
+        vector<ScenarioResult> trial_result(rate_num * trial_num);
+        if(rate_num == 0){
+            return result;
+        }
+        // A task is a trial and up to LANE_NUM adoption rates (one adoption rate without bitsliced).
+        const size_t chunk_size = setting.bitsliced ? LaneScenarioRunner::LANE_NUM : 1;
+        const size_t chunk_num = (rate_num + chunk_size - 1) / chunk_size;
+        unique_ptr<const LaneScenarioRunner> lane_runner;
+        if(setting.bitsliced){
+            lane_runner = make_unique<const LaneScenarioRunner>(runner);
+        }
+        #pragma omp parallel
+        {
+            LOTUS instance;
+            #pragma omp for schedule(dynamic, 1)
+            for(size_t task = 0; task < trial_num * chunk_num; ++task){
+                const size_t trial = task / chunk_num;
+                seed_seq pair_seq{setting.seed, static_cast<unsigned int>(trial)};
+                mt19937_64 pair_rng(pair_seq);
+                const ASNumber attacker = attacker_list[uniform_int_distribution<size_t>(0, attacker_list.size() - 1)(pair_rng)];
+                vector<ASNumber> candidate_list;
+                copy_if(victim_list.begin(), victim_list.end(), back_inserter(candidate_list), [&](ASNumber victim){ return victim != attacker; });
+                const ASNumber victim = candidate_list[uniform_int_distribution<size_t>(0, candidate_list.size() - 1)(pair_rng)];
+
+                const size_t rate_begin = (task % chunk_num) * chunk_size;
+                const size_t rate_end = min(rate_begin + chunk_size, rate_num);
+                vector<vector<ASNumber>> adopter_list_list;
+                for(size_t rate_index = rate_begin; rate_index < rate_end; ++rate_index){
+                    seed_seq seq{setting.seed, static_cast<unsigned int>(rate_index), static_cast<unsigned int>(trial)};
+                    mt19937_64 rng(seq);
+                    adopter_list_list.push_back(runner.choose_adopter_list(setting.adoption_rate_list[rate_index], rng));
+                }
+                if(lane_runner){
+                    const vector<ScenarioResult> lane_result = lane_runner->run(attacker, victim, adopter_list_list);
+                    for(size_t rate_index = rate_begin; rate_index < rate_end; ++rate_index){
+                        trial_result[rate_index * trial_num + trial] = lane_result[rate_index - rate_begin];
+                    }
+                }else{
+                    trial_result[rate_begin * trial_num + trial] = runner.run(Scenario{attacker, victim, adopter_list_list.front()}, instance);
+                }
+            }
+        }
+
+        for(size_t rate_index = 0; rate_index < rate_num; ++rate_index){
+            RunningEstimate estimate;
+            size_t success_num = 0;
+            for(size_t trial = 0; trial < trial_num; ++trial){
+                const ScenarioResult& r = trial_result[rate_index * trial_num + trial];
+                estimate.add(r.hijack_rate());
+                success_num += (0 < r.affected_num);
+            }
+            const double half_width = estimate.half_width(z);
+            result.push_back(SweepPoint{
+                setting.adoption_rate_list[rate_index],
+                estimate.count,
+                estimate.mean,
+                estimate.stddev(),
+                max(estimate.mean - half_width, 0.0),
+                min(estimate.mean + half_width, 1.0),
+                static_cast<double>(success_num) / trial_num
+            });
+        }
+        return result;
+    }
+
+    string to_csv(void) const {
+        ostringstream os;
+        os << setprecision(6);
+        os << "mechanism,attack_type,adoption_rate,trial_num,mean,stddev,ci_low,ci_high,success_rate\n";
+        for(const SweepPoint& p : result){
+            os << enum_name(setting.mechanism) << ',' << enum_name(setting.attack_type) << ',' << p.adoption_rate << ',' << p.trial_num << ','
+               << p.mean << ',' << p.stddev << ',' << p.ci_low << ',' << p.ci_high << ',' << p.success_rate << '\n';
+        }
+        return os.str();
+    }
+
+    string to_json(void) const {
+        ostringstream os;
+        os << setprecision(6);
+        os << "{\"mechanism\":\"" << enum_name(setting.mechanism) << "\",\"attack_type\":\"" << enum_name(setting.attack_type) << "\"";
+        os << ",\"seed\":" << setting.seed << ",\"confidence\":" << setting.confidence << ",\"result\":[";
+        for(size_t i = 0; i < result.size(); ++i){
+            const SweepPoint& p = result[i];
+            os << (i == 0 ? "" : ",") << "{\"adoption_rate\":" << p.adoption_rate << ",\"trial_num\":" << p.trial_num
+               << ",\"mean\":" << p.mean << ",\"stddev\":" << p.stddev << ",\"ci_low\":" << p.ci_low << ",\"ci_high\":" << p.ci_high
+               << ",\"success_rate\":" << p.success_rate << "}";
+        }
+        os << "]}\n";
+        return os.str();
+    }
+
+    void file_export(string file_path, bool json=false) const {
+        ofstream file(file_path);
+        if(!file){
+            std::cout << "\033[33m[WARN] \"" << file_path << "\" CANNOT be opened, the result was NOT exported.\033[00m" << std::endl;
+            return;
+        }
+        file << (json ? to_json() : to_csv());
+    }
+};
+
+struct SamplingSetting{
+    Policy mechanism = Policy::Aspa;                      // Policy::Aspa or Policy::Isec
+    AttackType attack_type = AttackType::ForgedOrigin;
+    vector<ASNumber> adopter_list = {};                   // adopting AS, the same for all samples
+    int priority = 1;
+    bool stratified = false;                              // pairs are drawn for each (tier of the attacker, tier of the victim)
+    double precision = 0.01;                              // sampling stops when the half width of the interval is at most this
+    double confidence = 0.95;
+    size_t min_sample_num = 30;
+    size_t max_sample_num = 100000;
+    size_t batch_size = 64;                               // samples evaluated in parallel before checking the precision
+    unsigned int seed = 0;
+};
+
+struct SamplingStratum{
+    int attacker_tier;  // 0 if not stratified
+    int victim_tier;
+    vector<ASNumber> attacker_list;
+    vector<ASNumber> victim_list;
+    double weight;      // fraction of the (attacker, victim) pairs in the stratum
+    RunningEstimate estimate;
+};
+
+class AttackSampler{
+    // Estimates the mean hijack rate over all (attacker, victim) pairs by sampling them at random.
+    // With stratification, the samples are allocated to the strata in proportion to their weights,
+    // and the estimate is the weighted mean of the strata.
+    // The pair of the k-th sample only depends on the seed and k, and the precision is checked after each batch,
+    // thus the result does not depend on the number of threads.
+public:
+    SamplingSetting setting;
+    vector<SamplingStratum> stratum_list;
+    size_t sample_num = 0;
+    double mean = 0.0;
+    double half_width = 0.0;
+    bool converged = false;  // whether the precision has been reached
+
+public:
+    AttackSampler(SamplingSetting setting){
+        this->setting = setting;
+    }
+
+    void run(LOTUS& lotus){
+        stratum_list.clear();
+        sample_num = 0;
+        mean = half_width = 0.0;
+        converged = false;
+        const double z = RunningEstimate::z_value(setting.confidence);
+        const ScenarioRunner runner(lotus, setting.mechanism, setting.attack_type, setting.priority);
+        if(setting.stratified){
+            vector<vector<ASNumber>> tier_list = {lotus.get_tier_AS_list(1), lotus.get_tier_AS_list(2), lotus.get_tier_AS_list(3)};
+            for(int attacker_tier = 1; attacker_tier <= 3; ++attacker_tier){
+                for(int victim_tier = 1; victim_tier <= 3; ++victim_tier){
+                    add_stratum(attacker_tier, victim_tier, tier_list[attacker_tier - 1], tier_list[victim_tier - 1]);
+                }
+            }
+        }else{
+            add_stratum(0, 0, runner.as_list, runner.as_list);
+        }
+        if(stratum_list.empty()){
+            std::cout << "\033[33m[WARN] There is no pair of a different attacker and victim, no sample has been drawn.\033[00m" << std::endl;
+            return;
+        }
+        double total_weight = 0.0;
+        for(const SamplingStratum& stratum : stratum_list){
+            total_weight += stratum.weight;
+        }
+        for(SamplingStratum& stratum : stratum_list){
+            stratum.weight /= total_weight;
+        }
+
+        const size_t batch_size = max<size_t>(setting.batch_size, 1);
+        vector<size_t> allocated_num(stratum_list.size(), 0);
+        while(sample_num < setting.max_sample_num){
+            // Each stratum has 2 samples at first (for its variance), then each sample goes to
+            // the stratum which has the fewest samples for its weight.
+            const size_t batch_num = min(batch_size, setting.max_sample_num - sample_num);
+            vector<int> batch_stratum(batch_num);
+            for(size_t i = 0; i < batch_num; ++i){
+                size_t chosen = 0;
+                for(size_t h = 1; h < stratum_list.size(); ++h){
+                    const bool short_h = allocated_num[h] < 2, short_chosen = allocated_num[chosen] < 2;
+                    if(short_h != short_chosen ? short_h : allocated_num[h] / stratum_list[h].weight < allocated_num[chosen] / stratum_list[chosen].weight){
+                        chosen = h;
+                    }
+                }
+                allocated_num[chosen] += 1;
+                batch_stratum[i] = static_cast<int>(chosen);
+            }
+
+            vector<ScenarioResult> batch_result(batch_num);
+            #pragma omp parallel
+            {
+                LOTUS instance;
+                #pragma omp for schedule(dynamic, 1)
+                for(size_t i = 0; i < batch_num; ++i){
+                    const SamplingStratum& stratum = stratum_list[batch_stratum[i]];
+                    seed_seq seq{setting.seed, static_cast<unsigned int>(sample_num + i), static_cast<unsigned int>((sample_num + i) >> 32)};
+                    mt19937_64 rng(seq);
+                    Scenario scenario;
+                    scenario.adopter_list = setting.adopter_list;
+                    scenario.attacker = stratum.attacker_list[uniform_int_distribution<size_t>(0, stratum.attacker_list.size() - 1)(rng)];
+                    do{
+                        scenario.victim = stratum.victim_list[uniform_int_distribution<size_t>(0, stratum.victim_list.size() - 1)(rng)];
+                    }while(scenario.victim == scenario.attacker);
+                    batch_result[i] = runner.run(scenario, instance);
+                }
+            }
+            for(size_t i = 0; i < batch_num; ++i){
+                stratum_list[batch_stratum[i]].estimate.add(batch_result[i].hijack_rate());
+            }
+            sample_num += batch_num;
+
+            update_estimate(z);
+            bool enough = setting.min_sample_num <= sample_num;
+            for(const SamplingStratum& stratum : stratum_list){
+                enough = enough && 2 <= stratum.estimate.count;
+            }
+            if(enough && half_width <= setting.precision){
+                converged = true;
+                break;
+            }
+        }
+        return;
+    }
+
+    string to_csv(void) const {
+        // One line for each stratum, and the last line for the estimate.
+        ostringstream os;
+        os << setprecision(6);
+        os << "mechanism,attack_type,attacker_tier,victim_tier,weight,sample_num,mean,ci_low,ci_high,converged\n";
+        for(const SamplingStratum& stratum : stratum_list){
+            const double h = stratum.estimate.half_width(RunningEstimate::z_value(setting.confidence));
+            os << enum_name(setting.mechanism) << ',' << enum_name(setting.attack_type) << ',' << stratum.attacker_tier << ',' << stratum.victim_tier << ','
+               << stratum.weight << ',' << stratum.estimate.count << ',' << stratum.estimate.mean << ',' << max(stratum.estimate.mean - h, 0.0) << ',' << min(stratum.estimate.mean + h, 1.0) << ",\n";
+        }
+        os << enum_name(setting.mechanism) << ',' << enum_name(setting.attack_type) << ",all,all,1," << sample_num << ',' << mean << ','
+           << max(mean - half_width, 0.0) << ',' << min(mean + half_width, 1.0) << ',' << (converged ? "true" : "false") << '\n';
+        return os.str();
+    }
+
+    string to_json(void) const {
+        ostringstream os;
+        os << setprecision(6);
+        os << "{\"mechanism\":\"" << enum_name(setting.mechanism) << "\",\"attack_type\":\"" << enum_name(setting.attack_type) << "\"";
+        os << ",\"seed\":" << setting.seed << ",\"confidence\":" << setting.confidence << ",\"precision\":" << setting.precision;
+        os << ",\"sample_num\":" << sample_num << ",\"mean\":" << mean << ",\"ci_low\":" << max(mean - half_width, 0.0) << ",\"ci_high\":" << min(mean + half_width, 1.0);
+        os << ",\"converged\":" << (converged ? "true" : "false") << ",\"strata\":[";
+        for(size_t h = 0; h < stratum_list.size(); ++h){
+            const SamplingStratum& stratum = stratum_list[h];
+            os << (h == 0 ? "" : ",") << "{\"attacker_tier\":" << stratum.attacker_tier << ",\"victim_tier\":" << stratum.victim_tier
+               << ",\"weight\":" << stratum.weight << ",\"sample_num\":" << stratum.estimate.count << ",\"mean\":" << stratum.estimate.mean
+               << ",\"stddev\":" << stratum.estimate.stddev() << "}";
+        }
+        os << "]}\n";
+        return os.str();
+    }
+
+private:
+    void add_stratum(int attacker_tier, int victim_tier, const vector<ASNumber>& attacker_list, const vector<ASNumber>& victim_list){
+        // Both lists are in ascending order. The pairs of the same AS are not counted.
+        vector<ASNumber> common_list;
+        set_intersection(attacker_list.begin(), attacker_list.end(), victim_list.begin(), victim_list.end(), back_inserter(common_list));
+        const double pair_num = static_cast<double>(attacker_list.size()) * victim_list.size() - common_list.size();
+        if(pair_num <= 0){
+            return;
+        }
+        stratum_list.push_back(SamplingStratum{attacker_tier, victim_tier, attacker_list, victim_list, pair_num, RunningEstimate{}});
+    }
+
+    void update_estimate(double z){
+        // Weighted mean of the strata, and the half width from the variance sum of w^2 s^2 / n.
+        mean = 0.0;
+        double variance = 0.0;
+        for(const SamplingStratum& stratum : stratum_list){
+            if(stratum.estimate.count == 0){
+                continue;
+            }
+            mean += stratum.weight * stratum.estimate.mean;
+            variance += stratum.weight * stratum.weight * stratum.estimate.variance() / stratum.estimate.count;
+        }
+        half_width = z * sqrt(variance);
+    }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SECURITY_REGISTRY_H
+#define SECURITY_REGISTRY_H
+
+/***
+ *** Read-only snapshot of the published security objects (ASPA, adoption of BGP-iSec, ProConID).
+ *** It is built once by LOTUS::run() and shared by the routing tables of all AS,
+ *** thus nothing is modified during the validation.
+ ***/
+
+class SecurityRegistry{
+public:
+    shared_ptr<const ASGraph> as_graph;
+    map<ASNumber, vector<ASNumber>> public_aspa_list;
+    vector<uint64_t> isec_adopted;  // bitmap over the dense ids of as_graph
+    Adjacency public_ProConID;      // dense id -> sorted dense ids
+
+public:
+    SecurityRegistry(){
+        as_graph = make_shared<const ASGraph>();
+    }
+    SecurityRegistry(shared_ptr<const ASGraph> as_graph, const map<ASNumber, vector<ASNumber>>& public_aspa_list, const vector<ASNumber>& isec_adopted_as_list, const map<ASNumber, vector<ASNumber>>& public_ProConID){
+        this->as_graph = as_graph;
+        this->public_aspa_list = public_aspa_list;
+
+        const size_t n = as_graph->size();
+        isec_adopted.assign((n + 63) / 64, 0);
+        for(const ASNumber as_number : isec_adopted_as_list){
+            int id = as_graph->get_id(as_number);
+            if(id >= 0){
+                isec_adopted[id >> 6] |= uint64_t{1} << (id & 63);
+            }
+        }
+
+        // Every AS on the connection list has a dense id, thus an AS without it is never on a path.
+        vector<vector<int>> ProConID_list(n);
+        for(auto it = public_ProConID.begin(); it != public_ProConID.end(); it++){
+            int customer = as_graph->get_id(it->first);
+            if(customer < 0){
+                continue;
+            }
+            for(const ASNumber provider_as : it->second){
+                int provider = as_graph->get_id(provider_as);
+                if(provider >= 0){
+                    ProConID_list[customer].push_back(provider);
+                }
+            }
+            sort(ProConID_list[customer].begin(), ProConID_list[customer].end());
+        }
+        this->public_ProConID.offset.assign(n + 1, 0);
+        for(size_t id = 0; id < n; ++id){
+            this->public_ProConID.offset[id + 1] = this->public_ProConID.offset[id] + ProConID_list[id].size();
+            this->public_ProConID.target.insert(this->public_ProConID.target.end(), ProConID_list[id].begin(), ProConID_list[id].end());
+        }
+    }
+
+    int get_id(ASNumber asn) const {
+        return as_graph->get_id(asn);
+    }
+
+    bool is_isec_adopted(int id) const {
+        return 0 <= id && ((isec_adopted[id >> 6] >> (id & 63)) & 1);
+    }
+
+    bool is_ProConID(int customer, int provider) const {
+        if(customer < 0 || provider < 0){
+            return false;
+        }
+        const IdRange ProConID = public_ProConID.of(customer);
+        return binary_search(ProConID.begin(), ProConID.end(), provider);
+    }
+
+    ASPV verify_pair(ASNumber customer, ASNumber provider) const {
+        auto it = public_aspa_list.find(customer);
+
+        if(it == public_aspa_list.end()){
+            return ASPV::Unknown;
+        }else{
+            const vector<ASNumber>& provider_list = it->second;
+            if(find(provider_list.begin(), provider_list.end(), provider) != provider_list.end()){
+                return ASPV::Valid;
+            }else{
+                return ASPV::Invalid;
+            }
+        }
+    }
+};
+
+inline const shared_ptr<const SecurityRegistry> EMPTY_SECURITY_REGISTRY = make_shared<const SecurityRegistry>();
+
+#endif
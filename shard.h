@@ -0,0 +1,241 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+/***
+ *** Binary streams over a file descriptor, used between the worker processes of LOTUS::run_sharded() and the coordinator,
+ *** for the files of the checkpoints, and for the messages spilled by MessageQueue.
+ *** The values are written in the byte order of the host, thus both ends MUST be on the same host.
+ ***/
+
+struct ShardSummary{
+    size_t network_num = 0;  // networks owned by the worker
+    size_t message_num = 0;  // messages processed by the worker
+    size_t block_num = 0;    // (AS, network) entries sent back to the coordinator
+};
+
+class PipeWriter{
+    int fd;
+    vector<char> buffer;
+
+public:
+    PipeWriter(int fd){
+        this->fd = fd;
+        buffer.reserve(1 << 16);
+    }
+
+    template <typename T>
+    void write(const T& value){
+        static_assert(is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void write_array(const vector<T>& list){
+        static_assert(is_trivially_copyable_v<T>);
+        write<uint64_t>(list.size());
+        append(list.data(), list.size() * sizeof(T));
+    }
+
+    void write_string(const string& s){
+        write<uint64_t>(s.size());
+        append(s.data(), s.size());
+    }
+
+    void write_message(const Message& msg){
+        // The optional members are preceded by a byte of the flags of their presence.
+        const uint8_t flags = (msg.dst ? 1 : 0) | (msg.address ? 2 : 0) | (msg.path ? 4 : 0) | (msg.come_from ? 8 : 0);
+        write<uint8_t>(flags);
+        write<uint8_t>(static_cast<uint8_t>(msg.type));
+        write<ASNumber>(msg.src);
+        if(msg.dst){
+            write<ASNumber>(*msg.dst);
+        }
+        if(msg.address){
+            write<IPAddress>(*msg.address);
+        }
+        if(msg.path){
+            write<uint32_t>(msg.path->size());
+            for(const variant<ASNumber, Itself>& as_on_path : *msg.path){
+                const ASNumber* as_number = get_if<ASNumber>(&as_on_path);
+                write<ASNumber>(as_number ? *as_number : ITSELF_AS_NUMBER);
+            }
+        }
+        if(msg.come_from){
+            write<uint8_t>(static_cast<uint8_t>(*msg.come_from));
+        }
+    }
+
+    bool flush(void){
+        // false if the other end has been closed.
+        size_t written = 0;
+        while(written < buffer.size()){
+            const ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+            if(n < 0 && errno == EINTR){
+                continue;
+            }else if(n <= 0){
+                return false;
+            }
+            written += n;
+        }
+        buffer.clear();
+        return true;
+    }
+
+private:
+    void append(const void* data, size_t size){
+        if(buffer.capacity() < buffer.size() + size && !buffer.empty() && !flush()){
+            throw logic_error("\n\033[31m[ERROR] The stream has been closed: " + string(__func__) + " at " + string(__FILE__) + ":" + to_string(__LINE__) + "\033[0m");
+        }
+        const char* bytes = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+};
+
+class PipeReader{
+    int fd;
+    off_t offset;  // -1: read from the current offset of the descriptor
+    vector<char> buffer;
+    size_t position = 0;
+
+public:
+    PipeReader(int fd, off_t offset=-1){
+        // With <offset>, the file is read by pread() from there, without moving the offset of the descriptor.
+        this->fd = fd;
+        this->offset = offset;
+    }
+
+    template <typename T>
+    bool read(T& value){
+        // false if the stream has ended before the value.
+        static_assert(is_trivially_copyable_v<T>);
+        return take(&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool read_array(vector<T>& list){
+        static_assert(is_trivially_copyable_v<T>);
+        uint64_t size;
+        if(!read(size)){
+            return false;
+        }
+        list.resize(size);
+        return take(list.data(), size * sizeof(T));
+    }
+
+    bool read_string(string& s){
+        uint64_t size;
+        if(!read(size)){
+            return false;
+        }
+        s.resize(size);
+        return take(s.data(), size);
+    }
+
+    bool read_message(Message& msg){
+        // A message written by PipeWriter::write_message().
+        uint8_t flags, type;
+        if(!read(flags) || !read(type) || !read(msg.src)){
+            return false;
+        }
+        msg.type = static_cast<MessageType>(type);
+        msg.dst = nullopt;
+        msg.address = nullopt;
+        msg.path = nullopt;
+        msg.come_from = nullopt;
+        if(flags & 1){
+            ASNumber dst;
+            if(!read(dst)){
+                return false;
+            }
+            msg.dst = dst;
+        }
+        if(flags & 2){
+            msg.address.emplace();
+            if(!read(*msg.address)){
+                return false;
+            }
+        }
+        if(flags & 4){
+            uint32_t size;
+            if(!read(size)){
+                return false;
+            }
+            msg.path.emplace();
+            msg.path->reserve(size);
+            for(uint32_t i = 0; i < size; ++i){
+                ASNumber as_number;
+                if(!read(as_number)){
+                    return false;
+                }
+                if(as_number == ITSELF_AS_NUMBER){
+                    msg.path->push_back(Itself::I);
+                }else{
+                    msg.path->push_back(as_number);
+                }
+            }
+        }
+        if(flags & 8){
+            uint8_t come_from;
+            if(!read(come_from)){
+                return false;
+            }
+            msg.come_from = static_cast<ComeFrom>(come_from);
+        }
+        return true;
+    }
+
+private:
+    bool take(void* data, size_t size){
+        char* bytes = static_cast<char*>(data);
+        while(0 < size){
+            if(position == buffer.size()){
+                buffer.resize(1 << 16);
+                position = 0;
+                ssize_t n;
+                do{
+                    n = (offset < 0) ? ::read(fd, buffer.data(), buffer.size()) : pread(fd, buffer.data(), buffer.size(), offset);
+                }while(n < 0 && errno == EINTR);
+                if(n <= 0){
+                    buffer.clear();
+                    return false;
+                }
+                buffer.resize(n);
+                if(0 <= offset){
+                    offset += n;
+                }
+            }
+            const size_t chunk = min(size, buffer.size() - position);
+            memcpy(bytes, buffer.data() + position, chunk);
+            bytes += chunk;
+            position += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+};
+
+template <typename Function>
+bool write_file_atomically(const string& file_path, Function write){
+    // write(PipeWriter&) fills a temporary file, which is then renamed to <file_path>, thus a reader never sees a partial file.
+    const string temporary_path = file_path + ".tmp" + to_string(getpid());
+    const int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        return false;
+    }
+    bool stored = false;
+    try{
+        PipeWriter writer(fd);
+        write(writer);
+        stored = writer.flush();
+    }catch(const logic_error&){
+        stored = false;
+    }
+    stored = (close(fd) == 0) && stored;
+    stored = stored && rename(temporary_path.c_str(), file_path.c_str()) == 0;
+    if(!stored){
+        unlink(temporary_path.c_str());
+    }
+    return stored;
+}
+
+#endif
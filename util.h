@@ -10,7 +10,45 @@ bool caseInsensitiveCompare(const std::string& str1, const std::string& str2) {
  *** For safety typing
  ***/
 using ASNumber = int;
-using IPAddress = string;
+
+struct IPv4Prefix{
+    // The address (host bits are 0) and the length of the prefix, ordered by the address and then the length.
+    uint32_t address = 0;
+    int length = 0;
+
+    static uint32_t mask(int length){
+        return length == 0 ? 0 : ~uint32_t{0} << (32 - length);
+    }
+
+    bool contains(uint32_t other_address) const {
+        return ((address ^ other_address) & mask(length)) == 0;
+    }
+
+    bool contains(const IPv4Prefix& other) const {
+        return length <= other.length && contains(other.address);
+    }
+
+    bool operator==(const IPv4Prefix& other) const {
+        return address == other.address && length == other.length;
+    }
+
+    bool operator!=(const IPv4Prefix& other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const IPv4Prefix& other) const {
+        return address < other.address || (address == other.address && length < other.length);
+    }
+};
+
+template <>
+struct std::hash<IPv4Prefix>{
+    size_t operator()(const IPv4Prefix& prefix) const {
+        return std::hash<uint64_t>()((static_cast<uint64_t>(prefix.address) << 6) | static_cast<uint64_t>(prefix.length));
+    }
+};
+
+using IPAddress = IPv4Prefix;
 
 /***
  *** enum definitions
@@ -21,6 +59,9 @@ using IPAddress = string;
 #define POLICY X(LocPrf) X(PathLength) X(Aspa) X(Isec)
 #define ASPV_TYPE X(Valid) X(Invalid) X(Unknown)
 #define ISEC_TYPE X(Valid) X(Invalid) X(Debug)
+#define RIB_MODE X(Full) X(BestOnly)
+#define FORWARDING_RESULT X(Delivered) X(Hijacked) X(BlackHoled) X(Looping)
+#define ATTACK_TYPE X(ForgedOrigin) X(SubPrefix)
 
 #define CREATE_ENUM_CLASS(ClassName, EnumValues) \
 enum class ClassName{ \
@@ -33,6 +74,9 @@ CREATE_ENUM_CLASS(ComeFrom, COMEFROM)
 CREATE_ENUM_CLASS(Policy, POLICY)
 CREATE_ENUM_CLASS(ASPV, ASPV_TYPE)
 CREATE_ENUM_CLASS(Isec, ISEC_TYPE)
+CREATE_ENUM_CLASS(RibMode, RIB_MODE)
+CREATE_ENUM_CLASS(ForwardingResult, FORWARDING_RESULT)
+CREATE_ENUM_CLASS(AttackType, ATTACK_TYPE)
 #undef X
 
 #define OPERATOR_COUT(ClassName, EnumValues)\
@@ -55,6 +99,42 @@ OPERATOR_COUT(Policy, POLICY)
 OPERATOR_COUT(ASPV, ASPV_TYPE)
 #define X(name) case Isec::name: os << #name; break;
 OPERATOR_COUT(Isec, ISEC_TYPE)
+#define X(name) case RibMode::name: os << #name; break;
+OPERATOR_COUT(RibMode, RIB_MODE)
+#define X(name) case ForwardingResult::name: os << #name; break;
+OPERATOR_COUT(ForwardingResult, FORWARDING_RESULT)
+#define X(name) case AttackType::name: os << #name; break;
+OPERATOR_COUT(AttackType, ATTACK_TYPE)
+#undef X
+
+#define FUNCTION_ENUM_NAME(ClassName, EnumValues)\
+const char* enum_name(ClassName value) {\
+    switch (value) {\
+        EnumValues\
+    }\
+    return nullptr;\
+}
+
+#define X(name) case MessageType::name: return #name;
+FUNCTION_ENUM_NAME(MessageType, MESSAGE_TYPE)
+#undef X
+#define X(name) case ConnectionType::name: return #name;
+FUNCTION_ENUM_NAME(ConnectionType, CONNECTION_TYPE)
+#undef X
+#define X(name) case ComeFrom::name: return #name;
+FUNCTION_ENUM_NAME(ComeFrom, COMEFROM)
+#undef X
+#define X(name) case Policy::name: return #name;
+FUNCTION_ENUM_NAME(Policy, POLICY)
+#undef X
+#define X(name) case ASPV::name: return #name;
+FUNCTION_ENUM_NAME(ASPV, ASPV_TYPE)
+#undef X
+#define X(name) case Isec::name: return #name;
+FUNCTION_ENUM_NAME(Isec, ISEC_TYPE)
+#undef X
+#define X(name) case AttackType::name: return #name;
+FUNCTION_ENUM_NAME(AttackType, ATTACK_TYPE)
 #undef X
 
 #endif
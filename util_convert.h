@@ -1,4 +1,18 @@
 namespace YAML{
+    template<>
+    struct convert<IPv4Prefix>{
+        static Node encode(const IPv4Prefix& prefix){
+            return Node(string_prefix(prefix));
+        }
+        static bool decode(const Node& node, IPv4Prefix& value){
+            if(!node.IsScalar()){ return false; }
+            optional<IPv4Prefix> prefix = parse_IPv4_prefix(node.Scalar());
+            if(!prefix){ return false; }
+            value = *prefix;
+            return true;
+        }
+    };
+
     template<>
     struct convert<MessageType>{
         static Node encode(const MessageType& msg_type){
@@ -219,18 +233,18 @@ namespace YAML{
     };
 
     template<>
-    struct convert<Route*>{
-        static Node encode(const Route* r){
+    struct convert<Route>{
+        static Node encode(const Route& r){
             Node node;
-            node["path"]      = string_path(r->path);
-            node["come_from"] = r->come_from;
-            node["LocPrf"]    = r->LocPrf;
-            node["best_path"] = r->best_path;
-            node["aspv"]      = r->aspv;
-            node["isec_v"]    = r->isec_v;
+            node["path"]      = string_path(r.path);
+            node["come_from"] = r.come_from;
+            node["LocPrf"]    = r.LocPrf;
+            node["best_path"] = r.best_path;
+            node["aspv"]      = r.aspv;
+            node["isec_v"]    = r.isec_v;
             return node;
         };
-        static bool decode(const Node& node, Route*& r){
+        static bool decode(const Node& node, Route& r){
             if(!node.IsMap()){
                 return false;
             }
@@ -242,7 +256,7 @@ namespace YAML{
             if(node["isec_v"] && !node["isec_v"].IsNull()){
                 isec_v = node["isec_v"].as<Isec>();
             }
-            r = new Route{
+            r = Route{
                 parse_path(node["path"].as<string>()),
                 node["come_from"].as<ComeFrom>(),
                 node["LocPrf"].as<int>(),
@@ -365,24 +379,29 @@ namespace YAML{
     struct convert<RoutingTable>{
         static Node encode(const RoutingTable& routing_table){
             Node node;
-            for(const auto& it : routing_table.table){
-                node[it.first] = it.second;
-            }
+            Route r;
+            routing_table.for_each_block([&](const IPAddress& network, const RouteBlock& block){
+                Node route_list(NodeType::Sequence);
+                for(size_t i = 0; i < block.size(); ++i){
+                    block.get_route(i, r);
+                    route_list.push_back(r);
+                }
+                node[network] = route_list;
+            });
             return node;
         };
         static bool decode(const Node& node, RoutingTable& routing_table){
             if(!node.IsMap()){
                 return false;
             }
-            map<IPAddress, vector<Route*>> table;
+            routing_table.clear();
             for(const auto& r : node){
                 IPAddress route_address = r.first.as<IPAddress>();
+                routing_table.get_block(route_address);
                 for(const auto& route : r.second){
-                    Route* new_route = route.as<Route*>();
-                    table[route_address].push_back(new_route);
+                    routing_table.add_route(route_address, route.as<Route>());
                 }
             }
-            routing_table.table = table;
             return true;
         }
     };
@@ -0,0 +1,861 @@
+#ifndef YAML_STREAM_H
+#define YAML_STREAM_H
+
+/***
+ *** Streaming reader for the YAML files of LOTUS.
+ *** Only the block style written by file_export() (and the empty flow collections "[]" / "{}",
+ *** flow sequences of scalars, quoted scalars and comments) is supported.
+ *** The lines are decoded one by one from the buffer, and no document tree is built.
+ ***/
+
+class YAMLStreamError : public runtime_error{
+public:
+    YAMLStreamError(const string& message, size_t line_number)
+        : runtime_error("line " + to_string(line_number) + ": " + message) {}
+    YAMLStreamError(const string& message)
+        : runtime_error(message) {}
+};
+
+struct YAMLLine{
+    int col;               // column where the content starts
+    string_view text;      // content, without indentation, comment and trailing spaces
+    size_t number;         // line number (1-origin)
+    const char* position;  // beginning of the line on the buffer
+};
+
+class YAMLStreamReader{
+public:
+    const char* cursor;
+    const char* end;
+    size_t line_number;
+    YAMLLine current;
+    bool has_current = false;
+
+public:
+    YAMLStreamReader(const char* begin, const char* end, size_t line_number=1){
+        this->cursor = begin;
+        this->end = end;
+        this->line_number = line_number;
+        load();
+    }
+
+    bool at_end(void) const {
+        return !has_current;
+    }
+
+    YAMLLine& line(void){
+        return current;
+    }
+
+    void next(void){
+        load();
+    }
+
+    static bool is_item(const YAMLLine& line){
+        return line.text.size() > 0 && line.text[0] == '-' && (line.text.size() == 1 || line.text[1] == ' ');
+    }
+
+    void enter_item(void){
+        // "- key: value" -> "key: value" at the column after the dash (the line may become empty).
+        size_t skip = 1;
+        while(skip < current.text.size() && current.text[skip] == ' '){
+            ++skip;
+        }
+        current.col += skip;
+        current.text.remove_prefix(skip);
+        if(current.text.empty()){
+            next();
+        }
+    }
+
+    bool split_key_value(string_view& key, string_view& value) const {
+        // The first ':' followed by a space (or at the end) outside the quotes separates the key and the value.
+        const string_view text = current.text;
+        if(text.empty() || text.front() == '{' || text.front() == '['){
+            return false;
+        }
+        char quote = 0;
+        for(size_t i = 0; i < text.size(); ++i){
+            if(quote){
+                if(text[i] == quote){
+                    quote = 0;
+                }
+            }else if((text[i] == '"' || text[i] == '\'') && i == 0){
+                quote = text[i];
+            }else if(text[i] == ':' && (i + 1 == text.size() || text[i + 1] == ' ')){
+                key = unquote(trim(text.substr(0, i)));
+                value = (i + 1 < text.size()) ? trim(text.substr(i + 1)) : string_view{};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void skip_children(int col){
+        // Skips the block under a key at <col> (deeper lines, or a sequence at the same column).
+        while(has_current && (col < current.col || (current.col == col && is_item(current)))){
+            next();
+        }
+    }
+
+    [[noreturn]] void error(const string& message) const {
+        throw YAMLStreamError(message, has_current ? current.number : line_number);
+    }
+
+    static string_view trim(string_view s){
+        while(!s.empty() && (s.front() == ' ' || s.front() == '\t')){ s.remove_prefix(1); }
+        while(!s.empty() && (s.back()  == ' ' || s.back()  == '\t')){ s.remove_suffix(1); }
+        return s;
+    }
+
+    static string_view unquote(string_view s){
+        // Escape sequences are not supported (never written by file_export()).
+        if(s.size() >= 2 && ((s.front() == '"' && s.back() == '"') || (s.front() == '\'' && s.back() == '\''))){
+            s = s.substr(1, s.size() - 2);
+            if(s.find('\\') != string_view::npos || s.find('\'') != string_view::npos){
+                throw YAMLStreamError("escaped scalars are not supported");
+            }
+        }
+        return s;
+    }
+
+    static bool is_null(string_view s){
+        return s.empty() || s == "~" || s == "null" || s == "Null" || s == "NULL";
+    }
+
+    template <typename Int>
+    Int to_int(string_view s) const {
+        s = unquote(s);
+        if(!s.empty() && s.front() == '+'){
+            s.remove_prefix(1);
+        }
+        Int value;
+        auto result = from_chars(s.data(), s.data() + s.size(), value);
+        if(result.ec != errc{} || result.ptr != s.data() + s.size()){
+            error("\"" + string(s) + "\" is not an integer");
+        }
+        return value;
+    }
+
+    bool to_bool(string_view s) const {
+        s = unquote(s);
+        for(const char* t : {"true", "True", "TRUE", "yes", "Yes", "YES", "on", "On", "ON", "y", "Y"}){
+            if(s == t){ return true; }
+        }
+        for(const char* f : {"false", "False", "FALSE", "no", "No", "NO", "off", "Off", "OFF", "n", "N"}){
+            if(s == f){ return false; }
+        }
+        error("\"" + string(s) + "\" is not a boolean");
+    }
+
+    template <typename Function>
+    void read_scalar_list(int parent_col, string_view value, Function f){
+        // f(string_view scalar) for each entry of "[a, b]", or of the block sequence under the key.
+        if(value.empty()){
+            if(has_current && parent_col < current.col && !is_item(current)){
+                value = current.text;
+                next();
+            }else{
+                while(has_current && parent_col <= current.col && is_item(current)){
+                    const int item_col = current.col;
+                    enter_item();
+                    f(unquote(current.text));
+                    next();
+                    if(has_current && item_col < current.col){
+                        error("nested sequences are not supported");
+                    }
+                }
+                return;
+            }
+        }
+        if(is_null(value)){
+            return;
+        }
+        if(value.size() < 2 || value.front() != '[' || value.back() != ']'){
+            error("a sequence is expected");
+        }
+        string_view inner = trim(value.substr(1, value.size() - 2));
+        while(!inner.empty()){
+            size_t comma = inner.find(',');
+            string_view entry = trim(inner.substr(0, comma));
+            if(entry.empty() || entry.front() == '[' || entry.front() == '{'){
+                error("nested flow collections are not supported");
+            }
+            f(unquote(entry));
+            if(comma == string_view::npos){
+                break;
+            }
+            inner = trim(inner.substr(comma + 1));
+        }
+    }
+
+    template <typename Function>
+    void read_item_list(int parent_col, string_view value, Function f){
+        // f(int item_col) for each item of the block sequence under the key,
+        // the current line is then the first line of the item (without the dash).
+        if(value.empty() && has_current && parent_col < current.col && !is_item(current)){
+            value = current.text;
+            next();
+        }
+        if(!value.empty()){
+            if(value != "[]" && !is_null(value)){
+                error("only the empty flow sequence is supported here");
+            }
+            return;
+        }
+        while(has_current && parent_col <= current.col && is_item(current)){
+            const int dash_col = current.col;
+            enter_item();
+            if(has_current && dash_col < current.col){
+                f(current.col);
+            }
+            if(has_current && dash_col < current.col){
+                error("unexpected indentation");
+            }
+        }
+    }
+
+    template <typename Function>
+    void read_map(int parent_col, string_view value, Function f){
+        // f(string_view key, string_view value, int col) for each entry of the block mapping under the key.
+        // f must consume the block under the entry (if any).
+        if(value.empty() && has_current && parent_col < current.col && !is_item(current)){
+            string_view key, inline_value;
+            if(!split_key_value(key, inline_value)){
+                value = current.text;
+                next();
+            }
+        }
+        if(!value.empty()){
+            if(value != "{}" && !is_null(value)){
+                error("only the empty flow mapping is supported here");
+            }
+            return;
+        }
+        if(!has_current || current.col <= parent_col){
+            return;
+        }
+        read_entries(current.col, f);
+    }
+
+    template <typename Function>
+    void read_entries(int col, Function f){
+        // Reads the entries of the mapping whose keys are at <col>.
+        while(has_current && current.col == col && !is_item(current)){
+            string_view key, value;
+            if(!split_key_value(key, value)){
+                error("a mapping entry is expected");
+            }
+            next();
+            f(key, value, col);
+        }
+    }
+
+private:
+    void load(void){
+        has_current = false;
+        while(cursor < end){
+            const char* line_begin = cursor;
+            const char* line_end = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+            if(line_end == nullptr){
+                line_end = end;
+                cursor = end;
+            }else{
+                cursor = line_end + 1;
+            }
+            size_t number = line_number++;
+            string_view text(line_begin, line_end - line_begin);
+            if(!text.empty() && text.back() == '\r'){
+                text.remove_suffix(1);
+            }
+            int col = 0;
+            while(col < static_cast<int>(text.size()) && text[col] == ' '){
+                ++col;
+            }
+            text.remove_prefix(col);
+            if(!text.empty() && text.front() == '\t'){
+                throw YAMLStreamError("tabs are not allowed as indentation", number);
+            }
+            text = strip_comment(text);
+            if(text.empty()){
+                continue;
+            }
+            if(col == 0 && (text == "---" || text == "...")){
+                continue;
+            }
+            if(text.front() == '&' || text.front() == '*' || text.front() == '!' || text.front() == '|' || text.front() == '>' || text.front() == '%'){
+                throw YAMLStreamError("anchors, tags and block scalars are not supported", number);
+            }
+            current = YAMLLine{col, text, number, line_begin};
+            has_current = true;
+            return;
+        }
+    }
+
+    static string_view strip_comment(string_view text){
+        char quote = 0;
+        for(size_t i = 0; i < text.size(); ++i){
+            if(quote){
+                if(text[i] == quote){
+                    quote = 0;
+                }
+            }else if(text[i] == '"' || text[i] == '\''){
+                if(i == 0 || text[i - 1] == ' '){
+                    quote = text[i];
+                }
+            }else if(text[i] == '#' && (i == 0 || text[i - 1] == ' ')){
+                return trim(text.substr(0, i));
+            }
+        }
+        return trim(text);
+    }
+};
+
+/***
+ *** The contents of a LOTUS YAML file, before being applied to a LOTUS instance.
+ ***/
+
+struct ImportedAS{
+    ASNumber as_number;
+    IPAddress network_address;
+    vector<Policy> policy;
+    RoutingTable routing_table;
+};
+
+struct ImportedLOTUS{
+    int IP_gen_seed = 0;
+    vector<ImportedAS> as_list;
+    vector<Connection> connection_list;
+    vector<Message> message_list;
+    vector<pair<ASNumber, vector<ASNumber>>> public_aspa_list;
+    vector<ASNumber> isec_adopted_as_list;
+    vector<pair<ASNumber, vector<ASNumber>>> public_ProConID;
+};
+
+class LOTUSYAMLLoader{
+public:
+    template <typename Enum>
+    static Enum to_enum(YAMLStreamReader& reader, string_view s){
+        // The same conversion as util_convert.h (through a YAML scalar).
+        s = YAMLStreamReader::unquote(s);
+        try{
+            return YAML::Node(string(s)).as<Enum>();
+        }catch(const YAML::Exception&){
+            reader.error("\"" + string(s) + "\" is not a valid value");
+        }
+    }
+
+    static IPAddress to_prefix(YAMLStreamReader& reader, string_view s){
+        s = YAMLStreamReader::unquote(s);
+        optional<IPv4Prefix> prefix = parse_IPv4_prefix(s);
+        if(!prefix){
+            reader.error("\"" + string(s) + "\" is not an IPv4 prefix");
+        }
+        return *prefix;
+    }
+
+    static ImportedLOTUS load(const string& buffer){
+        ImportedLOTUS imported;
+        YAMLStreamReader reader(buffer.data(), buffer.data() + buffer.size());
+        if(reader.at_end()){
+            return imported;
+        }
+        vector<pair<const char*, size_t>> as_item_list;  // (beginning, line number) of each item of "AS_list"
+        const char* as_list_end = nullptr;
+
+        reader.read_entries(reader.line().col, [&](string_view key, string_view value, int col){
+            if(key == "AS_list"){
+                // Only the boundaries of the items are found here, they are parsed in parallel later.
+                if(!value.empty()){
+                    reader.read_item_list(col, value, [&](int){ reader.error("unexpected item"); });
+                    return;
+                }
+                if(!reader.at_end() && col < reader.line().col && !YAMLStreamReader::is_item(reader.line())){
+                    reader.read_item_list(col, value, [&](int){});
+                    return;
+                }
+                while(!reader.at_end() && col <= reader.line().col && YAMLStreamReader::is_item(reader.line())){
+                    const int dash_col = reader.line().col;
+                    as_item_list.push_back({reader.line().position, reader.line().number});
+                    reader.next();
+                    while(!reader.at_end() && dash_col < reader.line().col){
+                        reader.next();
+                    }
+                }
+                as_list_end = reader.at_end() ? reader.end : reader.line().position;
+            }else if(key == "IP_gen_seed"){
+                imported.IP_gen_seed = reader.to_int<int>(value);
+            }else if(key == "connection"){
+                reader.read_item_list(col, value, [&](int item_col){
+                    Connection c;
+                    reader.read_entries(item_col, [&](string_view k, string_view v, int c_col){
+                        if(k == "src"){
+                            c.src = reader.to_int<ASNumber>(v);
+                        }else if(k == "dst"){
+                            c.dst = reader.to_int<ASNumber>(v);
+                        }else if(k == "type"){
+                            c.type = to_enum<ConnectionType>(reader, v);
+                        }
+                        reader.skip_children(c_col);
+                    });
+                    imported.connection_list.push_back(c);
+                });
+            }else if(key == "message"){
+                reader.read_item_list(col, value, [&](int item_col){
+                    Message msg;
+                    reader.read_entries(item_col, [&](string_view k, string_view v, int m_col){
+                        if(k == "type"){
+                            msg.type = to_enum<MessageType>(reader, v);
+                        }else if(k == "src"){
+                            msg.src = reader.to_int<ASNumber>(v);
+                        }else if(k == "dst"){
+                            msg.dst = reader.to_int<ASNumber>(v);
+                        }else if(k == "network"){
+                            msg.address = to_prefix(reader, v);
+                        }else if(k == "path"){
+                            msg.path = parse_path(YAMLStreamReader::unquote(v));
+                        }else if(k == "come_from"){
+                            msg.come_from = to_enum<ComeFrom>(reader, v);
+                        }
+                        reader.skip_children(m_col);
+                    });
+                    imported.message_list.push_back(msg);
+                });
+            }else if(key == "ASPA" || key == "public_ProConID"){
+                vector<pair<ASNumber, vector<ASNumber>>>& target = (key == "ASPA") ? imported.public_aspa_list : imported.public_ProConID;
+                reader.read_map(col, value, [&](string_view k, string_view v, int e_col){
+                    vector<ASNumber> as_list;
+                    reader.read_scalar_list(e_col, v, [&](string_view s){
+                        as_list.push_back(reader.to_int<ASNumber>(s));
+                    });
+                    target.push_back({reader.to_int<ASNumber>(k), as_list});
+                });
+            }else if(key == "isec_adopted_as_list"){
+                reader.read_scalar_list(col, value, [&](string_view s){
+                    imported.isec_adopted_as_list.push_back(reader.to_int<ASNumber>(s));
+                });
+            }else{
+                reader.skip_children(col);
+            }
+        });
+        if(!reader.at_end()){
+            reader.error("unexpected line");
+        }
+
+        /* AS LIST (in parallel) */
+        imported.as_list.resize(as_item_list.size());
+        string first_error;
+        #pragma omp parallel for schedule(dynamic, 16)
+        for(size_t i = 0; i < as_item_list.size(); ++i){
+            const char* item_end = (i + 1 < as_item_list.size()) ? as_item_list[i + 1].first : as_list_end;
+            try{
+                YAMLStreamReader item_reader(as_item_list[i].first, item_end, as_item_list[i].second);
+                load_AS(item_reader, imported.as_list[i]);
+            }catch(const exception& e){
+                #pragma omp critical
+                {
+                    if(first_error.empty()){
+                        first_error = e.what();
+                    }
+                }
+            }
+        }
+        if(!first_error.empty()){
+            throw YAMLStreamError(first_error);
+        }
+        return imported;
+    }
+
+    static ImportedLOTUS load_node(const YAML::Node& node){
+        // The same contents through the document tree of yaml-cpp (for the files the streaming reader does not support).
+        ImportedLOTUS imported;
+        imported.IP_gen_seed = node["IP_gen_seed"].as<int>();
+        for(const auto& as_node : node["AS_list"]){
+            imported.as_list.push_back(ImportedAS{
+                as_node["AS"].as<ASNumber>(),
+                as_node["network_address"].as<IPAddress>(),
+                as_node["policy"].as<vector<Policy>>(),
+                as_node["routing_table"].as<RoutingTable>()
+            });
+        }
+        for(const auto& c_node : node["connection"]){
+            imported.connection_list.push_back(Connection{c_node["type"].as<ConnectionType>(), c_node["src"].as<ASNumber>(), c_node["dst"].as<ASNumber>()});
+        }
+        for(const auto& m_node : node["message"]){
+            Message msg;
+            msg.type = m_node["type"].as<MessageType>();
+            msg.src  = m_node["src"].as<ASNumber>();
+            if(msg.type == MessageType::Update){
+                msg.dst     = m_node["dst"].as<ASNumber>();
+                msg.address = m_node["network"].as<IPAddress>();
+                msg.path    = parse_path(m_node["path"].as<string>());
+            }
+            imported.message_list.push_back(msg);
+        }
+        for(const auto& aspa_node : node["ASPA"]){
+            vector<ASNumber> provider_list;
+            for(const auto& provider : aspa_node.second){
+                provider_list.push_back(provider.as<ASNumber>());
+            }
+            imported.public_aspa_list.push_back({aspa_node.first.as<ASNumber>(), provider_list});
+        }
+        for(const auto& as_it : node["isec_adopted_as_list"]){
+            imported.isec_adopted_as_list.push_back(as_it.as<ASNumber>());
+        }
+        for(const auto& isec_node : node["public_ProConID"]){
+            vector<ASNumber> provider_list;
+            for(const auto& provider : isec_node.second){
+                provider_list.push_back(provider.as<ASNumber>());
+            }
+            imported.public_ProConID.push_back({isec_node.first.as<ASNumber>(), provider_list});
+        }
+        return imported;
+    }
+
+    static void load_AS(YAMLStreamReader& reader, ImportedAS& as){
+        const int dash_col = reader.line().col;
+        reader.enter_item();
+        if(reader.at_end() || reader.line().col <= dash_col){
+            reader.error("an AS is expected");
+        }
+        Route r;
+        reader.read_entries(reader.line().col, [&](string_view key, string_view value, int col){
+            if(key == "AS"){
+                as.as_number = reader.to_int<ASNumber>(value);
+            }else if(key == "network_address"){
+                as.network_address = to_prefix(reader, value);
+            }else if(key == "policy"){
+                reader.read_scalar_list(col, value, [&](string_view s){
+                    as.policy.push_back(to_enum<Policy>(reader, s));
+                });
+            }else if(key == "routing_table"){
+                reader.read_map(col, value, [&](string_view network_key, string_view network_value, int network_col){
+                    IPAddress network = to_prefix(reader, network_key);
+                    as.routing_table.get_block(network);
+                    reader.read_item_list(network_col, network_value, [&](int route_col){
+                        r.aspv = nullopt;
+                        r.isec_v = nullopt;
+                        reader.read_entries(route_col, [&](string_view k, string_view v, int r_col){
+                            if(k == "path"){
+                                parse_path(YAMLStreamReader::unquote(v), r.path);
+                            }else if(k == "come_from"){
+                                r.come_from = to_enum<ComeFrom>(reader, v);
+                            }else if(k == "LocPrf"){
+                                r.LocPrf = reader.to_int<int>(v);
+                            }else if(k == "best_path"){
+                                r.best_path = reader.to_bool(v);
+                            }else if(k == "aspv"){
+                                if(!YAMLStreamReader::is_null(v)){ r.aspv = to_enum<ASPV>(reader, v); }
+                            }else if(k == "isec_v"){
+                                if(!YAMLStreamReader::is_null(v)){ r.isec_v = to_enum<Isec>(reader, v); }
+                            }
+                            reader.skip_children(r_col);
+                        });
+                        as.routing_table.add_route(network, r);
+                    });
+                });
+            }else{
+                reader.skip_children(col);
+            }
+        });
+        if(!reader.at_end()){
+            reader.error("unexpected line");
+        }
+    }
+};
+
+/***
+ *** Streaming writer for the YAML files of LOTUS.
+ *** It writes the same text as YAML::Emitter (with SetIndent(1)) does for the document tree of util_convert.h,
+ *** without building the tree. Each line is appended to a string, which is written to the stream when it becomes large.
+ ***/
+
+class YAMLStreamWriter{
+public:
+    ostream& os;
+    string buffer;
+    static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+public:
+    YAMLStreamWriter(ostream& os) : os(os) {}
+
+    void append(const string& chunk){
+        buffer += chunk;
+        flush_if_full();
+    }
+
+    void flush_if_full(void){
+        // The last character ('\n') is kept, since YAML::Emitter does not write the last line feed.
+        if(FLUSH_SIZE < buffer.size()){
+            os.write(buffer.data(), buffer.size() - 1);
+            buffer.erase(0, buffer.size() - 1);
+        }
+    }
+
+    void finish(void){
+        if(!buffer.empty() && buffer.back() == '\n'){
+            buffer.pop_back();
+        }
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+        os.flush();
+    }
+
+    static void indent(string& out, int col){
+        out.append(col, ' ');
+    }
+
+    static void scalar(string& out, string_view s){
+        // Plain if YAML::Emitter writes it as it is, otherwise (rarely) YAML::Emitter is used.
+        if(is_plain(s)){
+            out += s;
+        }else{
+            YAML::Emitter emitter;
+            emitter << string(s);
+            out += emitter.c_str();
+        }
+    }
+
+    static void scalar(string& out, int value){
+        char digits[16];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    static void scalar(string& out, bool value){
+        out += value ? "true" : "false";
+    }
+
+    template <typename Enum>
+    static void scalar(string& out, const optional<Enum>& value){
+        const char* name = value ? enum_name(*value) : nullptr;
+        out += name ? name : "~";
+    }
+
+    static void path(string& out, const Path& path){
+        // The same as string_path().
+        string path_string;
+        for(auto it = path.rbegin(); it != path.rend(); ++it){
+            if(it != path.rbegin()){
+                path_string += '-';
+            }
+            if(const ASNumber* as_number = get_if<ASNumber>(&*it)){
+                scalar(path_string, *as_number);
+            }else{
+                path_string += 'I';
+            }
+        }
+        scalar(out, path_string);
+    }
+
+    template <typename Value>
+    static void entry(string& out, int col, string_view key, const Value& value){
+        // "key: value"
+        indent(out, col);
+        out += key;
+        out += ": ";
+        scalar(out, value);
+        out += '\n';
+    }
+
+    static void key(string& out, int col, string_view key){
+        // "key:" followed by a block
+        indent(out, col);
+        out += key;
+        out += ":\n";
+    }
+
+    static void item(string& out, int col){
+        // "- " of a block sequence, the first entry of the item follows on the same line.
+        indent(out, col);
+        out += "- ";
+    }
+
+    static void as_list(string& out, int col, const vector<ASNumber>& as_list){
+        if(as_list.empty()){
+            indent(out, col);
+            out += "[]\n";
+        }
+        for(const ASNumber as_number : as_list){
+            item(out, col);
+            scalar(out, as_number);
+            out += '\n';
+        }
+    }
+
+    static void as_map(string& out, int col, const map<ASNumber, vector<ASNumber>>& as_map){
+        if(as_map.empty()){
+            indent(out, col);
+            out += "{}\n";
+        }
+        for(const auto& [as_number, as_list] : as_map){
+            indent(out, col);
+            scalar(out, as_number);
+            out += ":\n";
+            YAMLStreamWriter::as_list(out, col + 2, as_list);
+        }
+    }
+
+private:
+    static bool is_plain(string_view s){
+        if(s.empty() || !isalnum(static_cast<unsigned char>(s.front())) || s.back() == ':'){
+            return false;
+        }
+        for(const char c : s){
+            if(!(isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '_' || c == '/' || c == ':' || c == '-')){
+                return false;
+            }
+        }
+        return !(s == "null" || s == "Null" || s == "NULL");
+    }
+};
+
+class LOTUSYAMLWriter{
+public:
+    using W = YAMLStreamWriter;
+
+    static void write_AS(string& out, const ASClass& as_class){
+        W::item(out, 2);
+        W::entry(out, 0, "AS", as_class.as_number);
+        W::entry(out, 4, "network_address", string_view(string_prefix(as_class.network_address)));
+        if(as_class.policy.empty()){
+            out += "    policy: ~\n";
+        }else{
+            W::key(out, 4, "policy");
+            for(const Policy& p : as_class.policy){
+                W::item(out, 6);
+                W::scalar(out, optional<Policy>(p));
+                out += '\n';
+            }
+        }
+        if(as_class.routing_table.empty()){
+            out += "    routing_table: ~\n";
+            return;
+        }
+        W::key(out, 4, "routing_table");
+        Route r;
+        as_class.routing_table.for_each_block([&](const IPAddress& network, const RouteBlock& block){
+            W::indent(out, 6);
+            W::scalar(out, string_prefix(network));
+            out += ":\n";
+            if(block.size() == 0){
+                W::indent(out, 8);
+                out += "[]\n";
+            }
+            for(size_t i = 0; i < block.size(); ++i){
+                block.get_route(i, r);
+                W::item(out, 8);
+                out += "path: ";
+                W::path(out, r.path);
+                out += '\n';
+                W::entry(out, 10, "come_from", optional<ComeFrom>(r.come_from));
+                W::entry(out, 10, "LocPrf", r.LocPrf);
+                W::entry(out, 10, "best_path", r.best_path);
+                W::entry(out, 10, "aspv", r.aspv);
+                W::entry(out, 10, "isec_v", r.isec_v);
+            }
+        });
+    }
+
+    static void write_AS_list(YAMLStreamWriter& writer, const ASClassList& as_class_list, bool parallel){
+        if(as_class_list.class_list.empty()){
+            return;
+        }
+        W::key(writer.buffer, 0, "AS_list");
+        if(!parallel){
+            for(const auto& it : as_class_list.class_list){
+                write_AS(writer.buffer, it.second);
+                writer.flush_if_full();
+            }
+            return;
+        }
+        // The AS are formatted in parallel by batches, and the chunks are written in order.
+        vector<const ASClass*> batch;
+        vector<string> chunk_list;
+        const size_t batch_size = 1024;
+        auto write_batch = [&](){
+            chunk_list.resize(batch.size());
+            #pragma omp parallel for schedule(dynamic, 8)
+            for(size_t i = 0; i < batch.size(); ++i){
+                chunk_list[i].clear();
+                write_AS(chunk_list[i], *batch[i]);
+            }
+            for(size_t i = 0; i < batch.size(); ++i){
+                writer.append(chunk_list[i]);
+            }
+            batch.clear();
+        };
+        for(const auto& it : as_class_list.class_list){
+            batch.push_back(&it.second);
+            if(batch.size() == batch_size){
+                write_batch();
+            }
+        }
+        write_batch();
+    }
+
+    static void write_connection_list(string& out, const vector<Connection>& connection_list){
+        W::key(out, 0, "connection");
+        if(connection_list.empty()){
+            out += "  []\n";
+        }
+        for(const Connection& c : connection_list){
+            W::item(out, 2);
+            W::entry(out, 0, "dst", c.dst);
+            W::entry(out, 4, "src", c.src);
+            W::entry(out, 4, "type", optional<ConnectionType>(c.type));
+        }
+    }
+
+    static void write_message(string& out, const Message& msg){
+        W::item(out, 2);
+        W::entry(out, 0, "type", optional<MessageType>(msg.type));
+        W::entry(out, 4, "src", msg.src);
+        if(msg.type == MessageType::Update){
+            W::entry(out, 4, "dst", *msg.dst);
+            W::entry(out, 4, "network", string_view(string_prefix(*msg.address)));
+            W::indent(out, 4);
+            out += "path: ";
+            W::path(out, *msg.path);
+            out += '\n';
+            // A message not received yet has no come_from, and "Customer" (the first value) has always been written for it.
+            W::entry(out, 4, "come_from", optional<ComeFrom>(msg.come_from.value_or(ComeFrom::Customer)));
+        }
+    }
+
+    static void write(ostream& os, const ASClassList& as_class_list, const vector<Connection>& connection_list, const MessageQueue& message_queue,
+                      const map<ASNumber, vector<ASNumber>>& public_aspa_list, const vector<ASNumber>& isec_adopted_as_list, const map<ASNumber, vector<ASNumber>>& public_ProConID,
+                      bool parallel){
+        YAMLStreamWriter writer(os);
+
+        /* AS LIST */
+        write_AS_list(writer, as_class_list, parallel);
+        W::entry(writer.buffer, 0, "IP_gen_seed", as_class_list.ip_gen.index);
+
+        /* CONNECTION LIST */
+        write_connection_list(writer.buffer, connection_list);
+        writer.flush_if_full();
+
+        /* MESSAGES LIST */
+        W::key(writer.buffer, 0, "message");
+        if(message_queue.empty()){
+            writer.buffer += "  []\n";
+        }
+        message_queue.for_each([&](const Message& msg){
+            write_message(writer.buffer, msg);
+            writer.flush_if_full();
+        });
+
+        /* SECURITY OBJECTS */
+        W::key(writer.buffer, 0, "ASPA");
+        W::as_map(writer.buffer, 2, public_aspa_list);
+        W::key(writer.buffer, 0, "isec_adopted_as_list");
+        W::as_list(writer.buffer, 2, isec_adopted_as_list);
+        W::key(writer.buffer, 0, "public_ProConID");
+        W::as_map(writer.buffer, 2, public_ProConID);
+        writer.finish();
+    }
+
+};
+
+#endif